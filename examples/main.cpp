@@ -1,12 +1,19 @@
+#include "aggregation.h"
 #include "application.h"
+#include "shm-feed.h"
+#include "table-model.h"
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+#include <thread>
 
 void sayHelloWorld(){
     // just for testing
     std::cout << "hello world" << std::endl;
 }
 
-std::function<void()> createTextCallback(CairoRenderer &renderer, bool &isVisible) {
+Button::Callback createTextCallback(CairoRenderer &renderer, bool &isVisible) {
     return [&renderer, &isVisible]() {
         if (isVisible) {
             renderer.clearArea(50, 200, 400, 100);
@@ -18,7 +25,7 @@ std::function<void()> createTextCallback(CairoRenderer &renderer, bool &isVisibl
     };
 }
 
-std::function<void()> showGeneralText(CairoRenderer &renderer, bool &isVisible) {
+Button::Callback showGeneralText(CairoRenderer &renderer, bool &isVisible) {
     return [&renderer, &isVisible]() {
         if (isVisible) {
             renderer.clearArea(20, 250, 130, 200);
@@ -59,10 +66,10 @@ std::vector<std::vector<std::string>> parseCSVData(std::ifstream &file) {
 }
 
 
-std::function<void()> parseFile(CairoRenderer &renderer, TextInput &textInput,
-                                std::vector<std::vector<std::string>> &csvData) {
+Button::Callback parseFile(CairoRenderer &renderer, TextInput &textInput,
+                                std::shared_ptr<const TableModel> &table) {
 
-    return [&renderer, &textInput, &csvData]() {
+    return [&renderer, &textInput, &table]() {
         std::string filePath = textInput.getInputText();
 
         std::ifstream file(filePath);
@@ -71,16 +78,16 @@ std::function<void()> parseFile(CairoRenderer &renderer, TextInput &textInput,
             return;
         }
 
-        csvData = parseCSVData(file);
+        table = std::make_shared<const TableModel>(parseCSVData(file));
         renderer.drawText("Finished processing", 230, 83, 0.0, 1.0, 0.0, 10);
 
     };
 }
 
-std::function<void()> showTable(CairoRenderer &renderer, int x, int y, std::vector<std::vector<std::string>> &csvData) {
-    return [&renderer, x, y, &csvData] {
-        int rows = csvData.size();
-        int cols = rows > 0 ? csvData[0].size() : 0;
+Button::Callback showTable(CairoRenderer &renderer, int x, int y, std::shared_ptr<const TableModel> &table) {
+    return [&renderer, x, y, &table] {
+        int rows = table ? table->rowCount() : 0;
+        int cols = table ? table->columnCount() : 0;
 
         if (rows == 0 || cols == 0) {
             renderer.drawText("No data in file", 20, 300, 1.0, 0.0, 0.0, 10);
@@ -92,41 +99,184 @@ std::function<void()> showTable(CairoRenderer &renderer, int x, int y, std::vect
         double textR = 1.0, textG = 1.0, textB = 1.0;
         double lineR = 0.5, lineG = 0.5, lineB = 0.5;
 
-        renderer.drawTable(csvData, x, y, cellWidth, cellHeight, rows, cols, textR, textG, textB, lineR, lineG, lineB);
+        renderer.drawTable(table->getRows(), x, y, cellWidth, cellHeight, rows, cols, textR, textG, textB, lineR, lineG, lineB);
     };
 }
 
 
-std::function<void()> showBarChart(CairoRenderer &renderer,
-                                   const std::vector<int> &values,
-                                   const std::vector<std::string> &labels,
-                                   std::optional<std::string> &title) {
-    return [&renderer, values, labels, title]() {
+// Sums the parsed CSV's second column per value of its first, under a header row.
+Button::Callback showColumnTotals(CairoRenderer &renderer, RenderStamp &chartArea,
+                                  std::shared_ptr<const TableModel> &table) {
+    return [&renderer, &chartArea, &table] {
+        if (!table || table->rowCount() < 2 || table->columnCount() < 2) {
+            renderer.drawText("No data in file", 20, 300, 1.0, 0.0, 0.0, 10);
+            return;
+        }
+        GroupedValues totals = aggregateBy(*table, 0, 1, Aggregation::Sum, 1);
+        chartArea.invalidate();
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawBarChart(totals.values, 320, 340, 300, 130, 0.8, 0.4, 0.6, totals.labels,
+                              std::optional<std::string>("Totals by " + table->getRows()[0][0]));
+    };
+}
+
+// Chart callbacks share their data instead of copying it into every callback.
+struct BarChartData {
+    Dataset<int> values;
+    std::vector<std::string> labels;
+    std::optional<std::string> title;
+};
+
+struct LineChartData {
+    Dataset<int> values_x;
+    Dataset<int> values_y;
+    std::optional<std::string> title;
+};
+
+struct PieChartData {
+    Dataset<int> values;
+    std::vector<std::tuple<double, double, double>> colors;
+    std::vector<std::string> labels;
+    std::optional<std::string> title;
+};
+
+// The three charts share one area; a chart that is already showing its
+// current data is not drawn again.
+Button::Callback showBarChart(CairoRenderer &renderer, RenderStamp &chartArea, std::shared_ptr<const BarChartData> data) {
+    return [&renderer, &chartArea, data]() {
+        if (!chartArea.changed({data->values.getVersion()})) return;
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawBarChart(data->values, 320, 340, 300, 130, 0.2, 0.6, 0.8, data->labels, data->title);
+    };
+}
+
+Button::Callback showLineChart(CairoRenderer &renderer, RenderStamp &chartArea, std::shared_ptr<const LineChartData> data) {
+    return [&renderer, &chartArea, data]() {
+        if (!chartArea.changed({data->values_x.getVersion(), data->values_y.getVersion()})) return;
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawLineChart(data->values_x, data->values_y, 320, 340, 300, 130, 0.0, 1.0, 0.0, data->title);
+    };
+}
+
+
+Button::Callback showPieChart(CairoRenderer &renderer, RenderStamp &chartArea, std::shared_ptr<const PieChartData> data) {
+    return [&renderer, &chartArea, data]() {
+        if (!chartArea.changed({data->values.getVersion()})) return;
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawPieChart(data->values, 450, 400, 60, data->colors, data->labels, data->title);
+    };
+}
+
+struct ScatterData {
+    Dataset<float> values_x;
+    Dataset<float> values_y;
+    std::optional<std::string> title;
+};
+
+// Two correlated clusters, noise summed from uniform draws.
+std::shared_ptr<const ScatterData> createPointCloud(size_t count) {
+    std::vector<float> xs(count);
+    std::vector<float> ys(count);
+    uint32_t noise = 67890;
+    auto uniform = [&noise] {
+        noise = noise * 1664525u + 1013904223u;
+        return static_cast<float>(noise >> 8) / 16777216.0f - 0.5f;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        float centre = (i % 3 == 0) ? 3.0f : 0.0f;
+        float a = uniform() + uniform() + uniform() + uniform();
+        float b = uniform() + uniform() + uniform() + uniform();
+        xs[i] = centre + a;
+        ys[i] = centre * 0.5f + 0.6f * a + 0.4f * b;
+    }
+    return std::make_shared<const ScatterData>(ScatterData{
+            Dataset<float>(std::move(xs)), Dataset<float>(std::move(ys)), "Point cloud"});
+}
+
+Button::Callback showScatterChart(CairoRenderer &renderer, RenderStamp &chartArea, std::shared_ptr<const ScatterData> data) {
+    return [&renderer, &chartArea, data]() {
+        if (!chartArea.changed({data->values_x.getVersion(), data->values_y.getVersion()})) return;
         renderer.clearArea(270, 300, 400, 400);
-        renderer.drawBarChart(values, 320, 340, 300, 130, 0.2, 0.6, 0.8, labels, title);
+        renderer.drawScatterChart(data->values_x, data->values_y, 320, 340, 300, 130, 1.0, 0.6, 0.1, data->title);
     };
 }
 
-std::function<void()> showLineChart(CairoRenderer &renderer,
-                                    const std::vector<int> &values_x,
-                                    const std::vector<int> &values_y,
-                                    const std::vector<std::string> &labels,
-                                    std::optional<std::string> &title) {
-    return [&renderer, values_x, values_y, labels, title]() {
+struct HeatmapData {
+    Dataset<double> values;
+    size_t rows;
+    size_t cols;
+    std::vector<std::string> rowLabels;
+    std::vector<std::string> columnLabels;
+    std::optional<std::string> title;
+};
+
+// Latency of 12 hosts over a day: a daily peak, a few slower hosts.
+std::shared_ptr<const HeatmapData> createLatencyMatrix() {
+    size_t hosts = 12, hours = 24;
+    std::vector<double> latency(hosts * hours);
+    std::vector<std::string> hostLabels;
+    std::vector<std::string> hourLabels;
+    for (size_t host = 0; host < hosts; ++host) {
+        hostLabels.push_back("host" + std::to_string(host + 1));
+        for (size_t hour = 0; hour < hours; ++hour) {
+            double peak = std::exp(-std::pow((static_cast<double>(hour) - 14.0) / 4.0, 2.0));
+            latency[host * hours + hour] = 20.0 + 60.0 * peak * (1.0 + 0.15 * static_cast<double>(host % 4));
+        }
+    }
+    for (size_t hour = 0; hour < hours; ++hour) {
+        hourLabels.push_back(std::to_string(hour) + "h");
+    }
+    return std::make_shared<const HeatmapData>(HeatmapData{
+            Dataset<double>(std::move(latency)), hosts, hours, std::move(hostLabels), std::move(hourLabels),
+            "Latency by hour (ms)"});
+}
+
+Button::Callback showHeatmap(CairoRenderer &renderer, RenderStamp &chartArea, std::shared_ptr<const HeatmapData> data) {
+    return [&renderer, &chartArea, data]() {
+        if (!chartArea.changed({data->values.getVersion()})) return;
         renderer.clearArea(270, 300, 400, 400);
-        renderer.drawLineChart(values_x, values_y, 320, 340, 300, 130, 0.0, 1.0, 0.0, title);
+        renderer.drawHeatmap(data->values, data->rows, data->cols, 330, 340, 300, 130,
+                             data->rowLabels, data->columnLabels, data->title);
     };
 }
 
+// Window over a long series; zooming and panning only move the window, the
+// pyramid is built once.
+struct SeriesView {
+    SeriesPyramid<double> series;
+    size_t first = 0;
+    size_t last = 0;
+    // Shared with the other charts drawn in the same area.
+    RenderStamp* chartArea = nullptr;
+};
+
+std::shared_ptr<SeriesView> createSyntheticSeries(size_t count, RenderStamp &chartArea) {
+    std::vector<double> samples(count);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        samples[i] = 100.0 + 50.0 * std::sin(i * 0.0002) + 10.0 * std::sin(i * 0.05) + (noise >> 24) / 16.0;
+    }
+    auto view = std::make_shared<SeriesView>(SeriesView{SeriesPyramid<double>(Dataset<double>(std::move(samples)))});
+    view->last = view->series.size();
+    view->chartArea = &chartArea;
+    return view;
+}
 
-std::function<void()> showPieChart(CairoRenderer &renderer,
-                                   const std::vector<int> &values,
-                                   const std::vector<std::tuple<double, double, double>> colors,
-                                   const std::vector<std::string> &labels,
-                                   std::optional<std::string> &title) {
-    return [&renderer, values, colors, labels, title]() {
+// Scales the window by zoom around its centre and moves it by pan windows.
+Button::Callback showSeries(CairoRenderer &renderer, std::shared_ptr<SeriesView> view, float zoom, float pan) {
+    return [&renderer, view, zoom, pan]() {
+        double size = static_cast<double>(view->series.size());
+        double width = std::clamp(static_cast<double>(view->last - view->first) * zoom, 16.0, size);
+        double centre = (view->first + view->last) / 2.0 + pan * width;
+        double first = std::clamp(centre - width / 2.0, 0.0, size - width);
+        view->first = static_cast<size_t>(first);
+        view->last = static_cast<size_t>(first + width);
+
+        view->chartArea->invalidate();
         renderer.clearArea(270, 300, 400, 400);
-        renderer.drawPieChart(values, 450, 400, 60, colors, labels, title);
+        renderer.drawLineChart(view->series, view->first, view->last, 320, 340, 300, 130, 0.0, 0.8, 1.0,
+                               std::optional<std::string>("Synthetic metric"));
     };
 }
 
@@ -144,49 +294,136 @@ void WaylandApplication::run() {
 
     Button button1(20, 200, 100, 30, "Show/Hide text", showGeneralText(renderer, isTextVisible));
 
-    std::vector<std::vector<std::string>> csvData;
-    Button button2(430, 115, 70, 20, "Parse CSV", parseFile(renderer, textInput, csvData));
-    Button button3(520, 115, 100, 20, "Show table", showTable(renderer, 220, 150, csvData));
+    std::shared_ptr<const TableModel> table;
+    Button button2(430, 115, 70, 20, "Parse CSV", parseFile(renderer, textInput, table));
+    Button button3(520, 115, 100, 20, "Show table", showTable(renderer, 220, 150, table));
 
     renderer.drawLine(200, 250, 1000, 250, 1.0, 1.0, 0.0, 1.2);
 
-    std::vector<int> values_bar_chart = {50, 100, 75, 150, 200};
-    std::vector<std::string> labels_bar_chart = {"val1", "val2", "val3", "val4", "val5"};
-    std::optional<std::string> title_bar = "Testing bar chart";
-
-    std::vector<int> values_x = {10, 30, 20, 50, 40};
-    std::vector<int> values_y = {10, 30, 20, 50, 40};
-    std::optional<std::string> title_line = "Testing Line Chart";
-
-    std::vector<int> values_pie = {10, 20, 30, 40};
-    std::vector<std::tuple<double, double, double>> colors = {
-            {1.0, 0.0, 0.0},
-            {0.0, 1.0, 0.0},
-            {0.0, 0.0, 1.0},
-            {1.0, 1.0, 0.0}
-    };
-
-    std::vector<std::string> labels_pie = {"one", "two", "three", "four"};
-    std::optional<std::string> title_pie = "Testing Pie Chart";
-
-
-    Button button4(230, 270, 100, 20, "Show bar chart",
-                   showBarChart(renderer, values_bar_chart, labels_bar_chart, title_bar));
-
-    Button button5(350, 270, 100, 20, "Show line chart",
-                   showLineChart(renderer, values_x, values_y, labels_bar_chart, title_line));
-
-    Button button6(470, 270, 100, 20, "Show pie chart",
-                   showPieChart(renderer, values_pie, colors, labels_pie, title_pie));
-
-
+    auto barChart = std::make_shared<const BarChartData>(BarChartData{
+            {50, 100, 75, 150, 200},
+            {"val1", "val2", "val3", "val4", "val5"},
+            "Testing bar chart",
+    });
+
+    auto lineChart = std::make_shared<const LineChartData>(LineChartData{
+            {10, 30, 20, 50, 40},
+            {10, 30, 20, 50, 40},
+            "Testing Line Chart",
+    });
+
+    auto pieChart = std::make_shared<const PieChartData>(PieChartData{
+            {10, 20, 30, 40},
+            {
+                    {1.0, 0.0, 0.0},
+                    {0.0, 1.0, 0.0},
+                    {0.0, 0.0, 1.0},
+                    {1.0, 1.0, 0.0}
+            },
+            {"one", "two", "three", "four"},
+            "Testing Pie Chart",
+    });
+
+
+    RenderStamp chartArea;
+    Button button16(630, 115, 80, 20, "Show totals", showColumnTotals(renderer, chartArea, table));
+    Button button4(230, 270, 100, 20, "Show bar chart", showBarChart(renderer, chartArea, barChart));
+
+    Button button5(350, 270, 100, 20, "Show line chart", showLineChart(renderer, chartArea, lineChart));
+
+    Button button6(470, 270, 100, 20, "Show pie chart", showPieChart(renderer, chartArea, pieChart));
+
+    Button button14(20, 240, 100, 20, "Show scatter", showScatterChart(renderer, chartArea, createPointCloud(10'000'000)));
+
+    Button button15(20, 265, 100, 20, "Show heatmap", showHeatmap(renderer, chartArea, createLatencyMatrix()));
+
+    auto seriesView = createSyntheticSeries(2'000'000, chartArea);
+    Button button7(590, 270, 100, 20, "Show series", showSeries(renderer, seriesView, 1.0f, 0.0f));
+    // Beside the chart area, which clearing the charts would wipe them from.
+    Button button8(685, 300, 20, 20, "+", showSeries(renderer, seriesView, 0.5f, 0.0f));
+    Button button9(685, 325, 20, 20, "-", showSeries(renderer, seriesView, 2.0f, 0.0f));
+    Button button10(685, 350, 20, 20, "<", showSeries(renderer, seriesView, 1.0f, -0.25f));
+    Button button11(685, 375, 20, 20, ">", showSeries(renderer, seriesView, 1.0f, 0.25f));
+
+    // A worker thread stands in for a metric sampled at 1 kHz; the chart
+    // follows the stream's last 600 samples while Live is on.
+    auto liveSeries = std::make_shared<StreamSeries<float>>(1 << 16, 600);
+    std::atomic<bool> streaming{false};
+    std::jthread producer([liveSeries, &streaming](std::stop_token stop) {
+        float phase = 0.0f;
+        while (!stop.stop_requested()) {
+            if (streaming.load(std::memory_order_relaxed)) {
+                float batch[4];
+                for (float& sample : batch) {
+                    phase += 0.01f;
+                    sample = 60.0f + 30.0f * std::sin(phase) + 10.0f * std::sin(phase * 7.3f);
+                }
+                liveSeries->push(std::span<const float>(batch));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+    });
 
-    renderer.addButton(button1);
-    renderer.addButton(button2);
-    renderer.addButton(button3);
-    renderer.addButton(button4);
-    renderer.addButton(button5);
-    renderer.addButton(button6);
+    std::vector<int32_t> sampleNumbers(600);
+    std::iota(sampleNumbers.begin(), sampleNumbers.end(), 0);
+    liveCharts.subscribe<float>(liveSeries, [this, &chartArea, &sampleNumbers](std::span<const float> window) {
+        chartArea.invalidate();
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawLineChart(std::span<const int32_t>(sampleNumbers).first(window.size()), window,
+                               320, 340, 300, 130, 1.0, 0.5, 0.0, std::optional<std::string>("Live metric"));
+    });
+    Button button12(685, 400, 30, 20, "Live", [&streaming] { streaming = !streaming; });
+
+    // Feed connects to a collector process publishing under /gwaytool-feed,
+    // such as GWayToolShmProducer, and charts it the same way.
+    auto feedSeries = std::make_shared<StreamSeries<double>>(1 << 16, 600);
+    std::jthread feedReader;
+    liveCharts.subscribe<double>(feedSeries, [this, &chartArea, &sampleNumbers](std::span<const double> window) {
+        chartArea.invalidate();
+        renderer.clearArea(270, 300, 400, 400);
+        renderer.drawLineChart(std::span<const int32_t>(sampleNumbers).first(window.size()), window,
+                               320, 340, 300, 130, 0.0, 0.8, 0.8, std::optional<std::string>("Shared memory feed"));
+    });
+    Button button13(685, 425, 30, 20, "Feed", [this, feedSeries, &feedReader] {
+        if (feedReader.joinable()) return;
+        std::unique_ptr<ShmFeedReader> feed;
+        try {
+            feed = std::make_unique<ShmFeedReader>("/gwaytool-feed");
+        } catch (const std::runtime_error& e) {
+            renderer.drawText(e.what(), 20, 300, 1.0, 0.0, 0.0, 10);
+            return;
+        }
+        feedReader = std::jthread([feed = std::move(feed), feedSeries](std::stop_token stop) {
+            while (!stop.stop_requested()) {
+                // Slots are pushed as soon as they are copied out and checked.
+                size_t read = feed->poll([&feedSeries](std::span<const double> samples) {
+                    feedSeries->push(samples);
+                });
+                if (read == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        });
+    });
+
+
+
+    renderer.addButton(std::move(button1));
+    renderer.addButton(std::move(button2));
+    renderer.addButton(std::move(button3));
+    renderer.addButton(std::move(button4));
+    renderer.addButton(std::move(button5));
+    renderer.addButton(std::move(button6));
+    renderer.addButton(std::move(button7));
+    renderer.addButton(std::move(button8));
+    renderer.addButton(std::move(button9));
+    renderer.addButton(std::move(button10));
+    renderer.addButton(std::move(button11));
+    renderer.addButton(std::move(button12));
+    renderer.addButton(std::move(button13));
+    renderer.addButton(std::move(button14));
+    renderer.addButton(std::move(button15));
+    renderer.addButton(std::move(button16));
 
 
     renderer.drawButton();
@@ -194,9 +431,7 @@ void WaylandApplication::run() {
     renderer.drawTextInput(textInput);
 
 
-    while (wl_display_dispatch(display.getDisplay()) != -1) {
-        // Main event loop
-    }
+    loop.run();
 }
 
 
@@ -0,0 +1,64 @@
+// Throughput of the shared memory feed: a writer thread publishes through a
+// memfd as fast as it can while a reader maps the same fd and sums the
+// samples in place. Usage: GWayToolShmBenchmark [million samples] [samples per slot]
+#include "shm-feed.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    long millions = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200;
+    long perSlot = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 256;
+    if (millions <= 0 || perSlot <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [million samples] [samples per slot]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t total = static_cast<size_t>(millions) * 1'000'000;
+
+    try {
+        ShmFeedWriter writer("", 4096, static_cast<uint32_t>(perSlot));
+        ShmFeedReader reader(writer.getFd());
+
+        std::vector<double> batch(static_cast<size_t>(perSlot));
+        std::iota(batch.begin(), batch.end(), 0.0);
+
+        std::atomic<bool> done{false};
+        std::chrono::duration<double> writing{};
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&] {
+            for (size_t written = 0; written < total; written += batch.size()) {
+                writer.write(batch);
+            }
+            writing = std::chrono::steady_clock::now() - start;
+            done.store(true, std::memory_order_release);
+        });
+
+        size_t received = 0;
+        double sum = 0.0;
+        auto consume = [&sum](std::span<const double> samples) {
+            sum = std::accumulate(samples.begin(), samples.end(), sum);
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            received += reader.poll(consume);
+        }
+        received += reader.poll(consume);
+        producer.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double written = static_cast<double>(total) / writing.count();
+        double rate = static_cast<double>(received) / elapsed.count();
+        std::cout << "Wrote " << total << " samples at " << written / 1e6 << " M samples/s\n"
+                  << "Read " << received << " samples in place at " << rate / 1e6 << " M samples/s, "
+                  << rate * sizeof(double) / 1e9 << " GB/s\n"
+                  << "  lost slots " << reader.getLost() << ", torn slots " << reader.getTorn()
+                  << ", checksum " << sum << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+// Stand-in for a collector process: publishes a synthetic metric under
+// /gwaytool-feed until interrupted. Usage: GWayToolShmProducer [samples per second]
+#include "shm-feed.h"
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t running = 1;
+
+void stop(int) {
+    running = 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    long rate = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 1000;
+    if (rate <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [samples per second]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    try {
+        ShmFeedWriter writer("/gwaytool-feed", 1024, 256);
+        std::cout << "Publishing " << rate << " samples/s on /gwaytool-feed" << std::endl;
+
+        // One batch per 10 ms tick.
+        auto tick = std::chrono::milliseconds(10);
+        std::vector<double> batch(static_cast<size_t>(std::max(rate / 100, 1L)));
+        double phase = 0.0;
+        auto next = std::chrono::steady_clock::now();
+        while (running) {
+            for (double& sample : batch) {
+                phase += 1.0 / static_cast<double>(rate);
+                sample = 50.0 + 25.0 * std::sin(phase * 2.0) + 10.0 * std::sin(phase * 13.0);
+            }
+            writer.write(batch);
+            next += tick;
+            std::this_thread::sleep_until(next);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
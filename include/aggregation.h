@@ -0,0 +1,81 @@
+#ifndef GWAYTOOL_AGGREGATION_H
+#define GWAYTOOL_AGGREGATION_H
+
+#include "dataset.h"
+#include "table-model.h"
+#include "thread-pool.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+// Aggregates over columns for the bar and pie charts. Rows are split into
+// one chunk per pool thread; each chunk aggregates into its own partial and
+// the partials are merged at the end, so no row is ever locked or shared.
+// NaN values are skipped.
+
+struct Summary {
+    uint64_t count = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    // 0 for no values.
+    double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+    void merge(const Summary& other);
+};
+
+enum class Aggregation {
+    Count,
+    Sum,
+    Min,
+    Max,
+    Mean,
+};
+
+template<ChartValue T>
+Summary summarize(std::span<const T> values, ThreadPool& pool = ThreadPool::shared());
+
+// Summary of the values of every group, values[i] belonging to group
+// codes[i]; rows with a code outside [0, groups) are skipped.
+template<ChartValue T>
+std::vector<Summary> groupBy(std::span<const int32_t> codes, size_t groups, std::span<const T> values,
+                             ThreadPool& pool = ThreadPool::shared());
+
+// Rows per group, for counting without a value column.
+std::vector<int64_t> countBy(std::span<const int32_t> codes, size_t groups, ThreadPool& pool = ThreadPool::shared());
+
+struct Histogram {
+    // bins + 1 edges; bin i holds values in [edges[i], edges[i + 1]), the
+    // last bin its upper edge too.
+    std::vector<double> edges;
+    std::vector<int64_t> counts;
+
+    // "lower-upper" per bin, for chart labels.
+    std::vector<std::string> labels() const;
+};
+
+// bins bins of equal width from the smallest value to the largest.
+template<ChartValue T>
+Histogram histogram(std::span<const T> values, size_t bins, ThreadPool& pool = ThreadPool::shared());
+
+// At most bins bins holding about equally many values each. Edges are
+// placed on a fine equal width histogram, so they are off by at most 1/65536
+// of the range, and one pass over the values serves edges and counts alike.
+// Runs of equal values can leave fewer bins.
+template<ChartValue T>
+Histogram quantileHistogram(std::span<const T> values, size_t bins, ThreadPool& pool = ThreadPool::shared());
+
+// One value per group, ready for drawBarChart and drawPieChart.
+struct GroupedValues {
+    std::vector<std::string> labels;
+    Dataset<double> values;
+};
+
+// Aggregates valueColumn by the categories of groupColumn, from firstRow on;
+// Count ignores valueColumn.
+GroupedValues aggregateBy(const TableModel& table, size_t groupColumn, size_t valueColumn, Aggregation aggregation,
+                          size_t firstRow = 0, ThreadPool& pool = ThreadPool::shared());
+
+#endif //GWAYTOOL_AGGREGATION_H
@@ -14,9 +14,29 @@
 #include <vector>
 #include "button.h"
 #include "text-field.h"
+#include "event-loop.h"
+#include "live-charts.h"
 #include <sstream>
 #include <fstream>
 
+// Pointer events received between two wl_pointer.frame events.
+struct PointerFrame {
+    struct Button {
+        uint32_t button;
+        bool pressed;
+    };
+
+    bool moved = false;
+    int x = 0;
+    int y = 0;
+    std::vector<Button> buttons;
+    double scrollX = 0;
+    double scrollY = 0;
+    // The pointer entered or left the surface.
+    bool entered = false;
+    bool left = false;
+};
+
 class WaylandApplication {
 public:
     WaylandApplication();
@@ -28,13 +48,17 @@ public:
     static const struct wl_keyboard_listener keyboard_listener;
     void onMouseMove(int x, int y);
     void onMouseRelease(int x, int y);
+    // Buttons are handled right away, motion at most once per frame callback.
+    void onPointerFrame(const PointerFrame& frame);
 private:
     WaylandDisplay display;
+    EventLoop loop{display.getDisplay()};
     WaylandSurface surface;
     MyEGLContext egl;
     struct wl_egl_window* egl_window;
     EGLSurface egl_surface;
     CairoRenderer renderer;
+    LiveCharts liveCharts{loop, renderer, surface.getSurface()};
     std::vector<std::string> lines;
 
 
@@ -47,9 +71,32 @@ private:
 
 
 
+    static void keyboardKeymapHandler(void* data, struct wl_keyboard* keyboard,
+                                      uint32_t format, int32_t fd, uint32_t size);
     static void keyboardKeyHandler(void* data, struct wl_keyboard* keyboard,
                                    uint32_t serial, uint32_t time, uint32_t key,
                                    uint32_t state);
+    static void keyboardModifiersHandler(void* data, struct wl_keyboard* keyboard,
+                                         uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched,
+                                         uint32_t mods_locked, uint32_t group);
+
+    bool motionDeferred = false;
+    bool pointerInside = false;
+    void flushMotion();
+    // Shows the tooltip of the chart point at (x, y), or hides it; motion
+    // coalesced into one frame looks up once.
+    void hoverCharts(int x, int y);
+
+    // Read end of the pipe a paste is streamed through, -1 when idle.
+    int pasteFd = -1;
+
+    void startPaste();
+    void readPaste();
+
+    KeyModifiers currentModifiers() const;
+    // Repaints the text input, or only its caret and selection when the
+    // text did not change.
+    void redrawTextInput(const Rect& caretBefore, uint64_t revisionBefore, bool focusBefore);
 
 };
 #endif //GWAYTOOL_APPLICATION_H
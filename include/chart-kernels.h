@@ -0,0 +1,35 @@
+#ifndef GWAYTOOL_CHART_KERNELS_H
+#define GWAYTOOL_CHART_KERNELS_H
+
+#include "dataset.h"
+#include <cstddef>
+#include <span>
+#include <utility>
+
+// Bulk kernels the charts scale their data with. Each picks AVX2 or NEON
+// code when the CPU has it, and plain loops otherwise; the choice is made
+// once per process.
+
+// Smallest and largest value, skipping NaN, which comes back only when every
+// value is NaN; values must not be empty.
+template<ChartValue T>
+std::pair<T, T> minMaxOf(std::span<const T> values);
+
+// Sum in double.
+template<ChartValue T>
+double sumOf(std::span<const T> values);
+
+// out[i] = offset + scale * values[i], computed in double and stored as the
+// float coordinates cairo paths are built from. out must be as long as values.
+template<ChartValue T>
+void affineTransform(std::span<const T> values, double scale, double offset, std::span<float> out);
+
+// out[n] = offset + scale * values[indices[n]], for decimated series.
+template<ChartValue T>
+void affineGather(std::span<const T> values, std::span<const size_t> indices, double scale, double offset,
+                  std::span<float> out);
+
+// Name of the code path in use, for the log.
+const char* chartKernelIsa();
+
+#endif //GWAYTOOL_CHART_KERNELS_H
@@ -0,0 +1,79 @@
+#ifndef GWAYTOOL_CHART_LAYERS_H
+#define GWAYTOOL_CHART_LAYERS_H
+
+#include "geometry.h"
+#include <cairo/cairo.h>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Offscreen layers holding the static parts of charts: axes, ticks, tick
+// labels and titles. A layer is found by a key naming everything its drawing
+// depends on (chart kind, geometry, scale labels, title), so a chart whose
+// data changed within the same scale only redraws its data on top.
+class ChartLayerCache {
+public:
+    explicit ChartLayerCache(size_t capacity = 16) : capacity(capacity) {}
+    ~ChartLayerCache() { clear(); }
+
+    ChartLayerCache(const ChartLayerCache&) = delete;
+    ChartLayerCache& operator=(const ChartLayerCache&) = delete;
+
+    // Paints the layer for key onto cr. When no layer matches, draw(cr) is
+    // called once with a context in the same coordinates and its result
+    // becomes the layer.
+    template<typename Draw>
+    void paint(cairo_t* cr, const std::string& key, Draw&& draw);
+    void clear();
+
+private:
+    struct Layer {
+        std::string key;
+        Rect bounds;
+        cairo_surface_t* surface;
+        uint64_t lastUse;
+    };
+
+    size_t capacity;
+    std::vector<Layer> layers;
+    uint64_t uses = 0;
+
+    const Layer* find(const std::string& key);
+    // Rasterizes recording into a surface like target, evicting the least
+    // recently used layer when full. Takes ownership of recording.
+    const Layer& store(cairo_surface_t* target, const std::string& key, cairo_surface_t* recording);
+    void paintLayer(cairo_t* cr, const Layer& layer);
+};
+
+template<typename Draw>
+void ChartLayerCache::paint(cairo_t* cr, const std::string& key, Draw&& draw) {
+    const Layer* layer = find(key);
+    if (!layer) {
+        // Recorded first, so the layer is sized to what was drawn.
+        cairo_surface_t* recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+        cairo_t* recording_cr = cairo_create(recording);
+        draw(recording_cr);
+        cairo_destroy(recording_cr);
+        layer = &store(cairo_get_target(cr), key, recording);
+    }
+    paintLayer(cr, *layer);
+}
+
+// Joins the parts of a layer key; numbers are written out in full.
+template<typename... Parts>
+std::string chartLayerKey(const Parts&... parts) {
+    std::string key;
+    auto append = [&key](const auto& part) {
+        if constexpr (std::is_arithmetic_v<std::decay_t<decltype(part)>>) {
+            key += std::to_string(part);
+        } else {
+            key += part;
+        }
+        key += '\x1f';
+    };
+    (append(parts), ...);
+    return key;
+}
+
+#endif //GWAYTOOL_CHART_LAYERS_H
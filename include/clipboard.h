@@ -0,0 +1,59 @@
+#ifndef GWAYTOOL_CLIPBOARD_H
+#define GWAYTOOL_CLIPBOARD_H
+
+#include <wayland-client.h>
+#include <wayland-client-protocol.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tracks the wl_data_device selection of a seat so its text can be pasted.
+class Clipboard {
+public:
+    Clipboard() = default;
+    ~Clipboard();
+
+    Clipboard(const Clipboard&) = delete;
+    Clipboard& operator=(const Clipboard&) = delete;
+
+    // The data device is created once both globals are known.
+    void setManager(struct wl_data_device_manager* manager);
+    void setSeat(struct wl_seat* seat);
+
+    // Destroys the offers, must happen before the display disconnects.
+    void reset();
+
+    bool hasText() const;
+    // Asks the selection owner to write its text into a pipe and returns the
+    // non-blocking read end, or -1 when there is nothing to paste.
+    // The caller owns the fd and must flush the display for the request to go out.
+    int receiveText();
+
+private:
+    struct wl_data_device_manager* manager = nullptr;
+    struct wl_seat* seat = nullptr;
+    struct wl_data_device* device = nullptr;
+
+    // Mime types announced for every offer we have not dropped yet.
+    std::unordered_map<struct wl_data_offer*, std::vector<std::string>> offers;
+    struct wl_data_offer* selection = nullptr;
+    struct wl_data_offer* dragOffer = nullptr;
+
+    void createDevice();
+    void dropOffer(struct wl_data_offer* offer);
+    const char* textMimeType() const;
+
+    static void dataOfferHandler(void* data, struct wl_data_device* device, struct wl_data_offer* offer);
+    static void enterHandler(void* data, struct wl_data_device* device, uint32_t serial,
+                             struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y, struct wl_data_offer* offer);
+    static void leaveHandler(void* data, struct wl_data_device* device);
+    static void motionHandler(void* data, struct wl_data_device* device, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+    static void dropHandler(void* data, struct wl_data_device* device);
+    static void selectionHandler(void* data, struct wl_data_device* device, struct wl_data_offer* offer);
+    static void offerHandler(void* data, struct wl_data_offer* offer, const char* mimeType);
+
+    static const struct wl_data_device_listener data_device_listener;
+    static const struct wl_data_offer_listener data_offer_listener;
+};
+
+#endif //GWAYTOOL_CLIPBOARD_H
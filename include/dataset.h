@@ -0,0 +1,77 @@
+#ifndef GWAYTOOL_DATASET_H
+#define GWAYTOOL_DATASET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Value types the charts and their kernels are instantiated for.
+template<typename T>
+concept ChartValue = std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> ||
+                     std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Every new buffer gets a version no other buffer had, starting at 1.
+uint64_t nextDatasetVersion();
+
+// Immutable, reference counted series of values in contiguous memory. Copies
+// share the buffer, so charts and the callbacks drawing them can all hold the
+// same data. Equal versions mean equal contents, which lets a chart tell
+// whether its data changed since it was last rendered.
+template<typename T>
+class Dataset {
+public:
+    Dataset() = default;
+
+    explicit Dataset(std::vector<T> values) {
+        auto buffer = std::make_shared<const std::vector<T>>(std::move(values));
+        data = std::span<const T>(*buffer);
+        owner = std::move(buffer);
+        version = nextDatasetVersion();
+    }
+
+    Dataset(std::initializer_list<T> values) : Dataset(std::vector<T>(values)) {
+    }
+
+    // Views values that owner keeps alive, like a column cached by a table model.
+    Dataset(std::shared_ptr<const void> owner, std::span<const T> values, uint64_t version)
+            : owner(std::move(owner)), data(values), version(version) {
+    }
+
+    std::span<const T> values() const { return data; }
+    size_t size() const { return data.size(); }
+    bool empty() const { return data.empty(); }
+    const T& operator[](size_t index) const { return data[index]; }
+    auto begin() const { return data.begin(); }
+    auto end() const { return data.end(); }
+
+    // 0 for an empty default constructed dataset.
+    uint64_t getVersion() const { return version; }
+
+private:
+    std::shared_ptr<const void> owner;
+    std::span<const T> data;
+    uint64_t version = 0;
+};
+
+// Versions of the datasets something was last rendered from.
+class RenderStamp {
+public:
+    // Records versions and returns whether they differ from the previous ones.
+    bool changed(std::initializer_list<uint64_t> versions) {
+        if (std::equal(versions.begin(), versions.end(), rendered.begin(), rendered.end())) return false;
+        rendered.assign(versions);
+        return true;
+    }
+
+    // The next changed() call reports a change, for when the output was erased.
+    void invalidate() { rendered.clear(); }
+
+private:
+    std::vector<uint64_t> rendered;
+};
+
+#endif //GWAYTOOL_DATASET_H
@@ -0,0 +1,30 @@
+#ifndef GWAYTOOL_DECIMATE_H
+#define GWAYTOOL_DECIMATE_H
+
+#include "dataset.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Reduces a series to the points worth drawing. Both append indices into
+// values to out in increasing order, always keeping the first and last point,
+// and treat the index as the x coordinate, like the line chart does.
+
+enum class Decimation {
+    // First, minimum, maximum and last sample of every pixel column. Draws the
+    // same pixels as the full series for a 1 pixel wide line.
+    MinMax,
+    // Largest-Triangle-Three-Buckets: one point per bucket, the one spanning
+    // the largest triangle with its neighbours. Smoother, may drop lone spikes.
+    Lttb,
+};
+
+// At most 4 points per column.
+template<ChartValue T>
+void decimateMinMax(std::span<const T> values, size_t columns, std::vector<size_t>& out);
+
+// threshold points, or every point if there are not more than that.
+template<ChartValue T>
+void decimateLttb(std::span<const T> values, size_t threshold, std::vector<size_t>& out);
+
+#endif //GWAYTOOL_DECIMATE_H
@@ -9,6 +9,7 @@
 #include <xdg-shell-client-protocol.h>
 #include <string>
 #include "button.h"
+#include "clipboard.h"
 
 class WaylandDisplay {
 public:
@@ -18,6 +19,7 @@ public:
     struct wl_display* getDisplay() const { return display; }
     struct wl_compositor* getCompositor() const { return compositor; }
     struct xdg_wm_base* getXdgWmBase() const { return xdg_wm_base; }
+    Clipboard& getClipboard() { return clipboard; }
 
     void roundtrip();
     static void pointerButtonHandler(void* data, struct wl_pointer* pointer,
@@ -29,6 +31,7 @@ private:
     struct wl_registry* registry;
     struct wl_compositor* compositor;
     struct xdg_wm_base* xdg_wm_base;
+    Clipboard clipboard;
     static void registryHandler(void* data, struct wl_registry* registry,
                                 uint32_t id, const char* interface, uint32_t version);
     static void registryRemoveHandler(void* data, struct wl_registry* registry, uint32_t id);
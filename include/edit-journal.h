@@ -0,0 +1,88 @@
+#ifndef GWAYTOOL_EDIT_JOURNAL_H
+#define GWAYTOOL_EDIT_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class EditType : uint8_t {
+    Insert = 1,
+    Erase = 2
+};
+
+// A single edit of a document, positions are byte offsets.
+struct EditOp {
+    EditType type = EditType::Insert;
+    uint64_t sequence = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;  // bytes removed by an Erase
+    std::string text;     // bytes added by an Insert
+
+    static EditOp insert(uint64_t offset, std::string text) {
+        EditOp op;
+        op.type = EditType::Insert;
+        op.offset = offset;
+        op.length = text.size();
+        op.text = std::move(text);
+        return op;
+    }
+
+    static EditOp erase(uint64_t offset, uint64_t length) {
+        EditOp op;
+        op.type = EditType::Erase;
+        op.offset = offset;
+        op.length = length;
+        return op;
+    }
+};
+
+// Returns false if the edit does not fit the document.
+bool applyEdit(std::string& document, const EditOp& op);
+
+// Append-only binary log of EditOps next to a compacted snapshot.
+//
+//   <path>.journal   magic, then records: u32 size, u32 crc32, payload
+//   <path>.snapshot  magic, u64 sequence, u64 size, u32 crc32, document
+//
+// A snapshot holds every edit up to its sequence number; journal records at
+// or below it are leftovers of an interrupted compaction and are skipped.
+// Not thread safe, TextPersistence drives it from its writer thread.
+class EditJournal {
+public:
+    explicit EditJournal(const std::string& path);
+    ~EditJournal();
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    struct Recovered {
+        std::string document;
+        uint64_t sequence = 0;
+        size_t replayedEdits = 0;
+    };
+
+    // Loads the snapshot and replays the journal on top of it. A torn or
+    // corrupt tail (e.g. from a crash mid write) is cut off.
+    Recovered recover();
+
+    void append(const std::vector<EditOp>& ops);
+    void sync();
+    // Writes document as the new snapshot and empties the journal.
+    void compact(const std::string& document, uint64_t sequence);
+
+    size_t getJournalBytes() const { return journalBytes; }
+    bool isEmpty() const;
+
+private:
+    std::string journalPath;
+    std::string snapshotPath;
+    int journalFd = -1;
+    size_t journalBytes = 0;
+    std::vector<char> encodeBuffer;
+
+    bool readSnapshot(Recovered& recovered);
+    void resetJournal();
+};
+
+#endif //GWAYTOOL_EDIT_JOURNAL_H
@@ -0,0 +1,92 @@
+#ifndef GWAYTOOL_EVENT_LOOP_H
+#define GWAYTOOL_EVENT_LOOP_H
+
+#include <wayland-client.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Single threaded epoll loop around the Wayland connection. Besides the
+// display fd it watches user fds, timers (timerfd), signals (signalfd) and an
+// eventfd that wakes it up for tasks posted from other threads.
+// Everything except post() and quit() must be called on the loop thread.
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+    using FdCallback = std::function<void(uint32_t events)>;
+    using SignalCallback = std::function<void(int signal)>;
+
+    explicit EventLoop(struct wl_display* display);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Dispatches until quit() is called or the display connection breaks.
+    void run();
+    void quit();
+
+    // events is a mask of EPOLLIN/EPOLLOUT, the callback gets the ready ones.
+    // The loop does not own fd, remove it before closing it.
+    void addFd(int fd, uint32_t events, FdCallback callback);
+    void removeFd(int fd);
+
+    // Fires once after delay, then every interval unless it is zero.
+    // Returns an id for cancelTimer; one-shot timers cancel themselves.
+    int addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval, Callback callback);
+    void cancelTimer(int id);
+
+    // Blocks the signal for the calling thread and delivers it through the loop.
+    // Threads started earlier must block it themselves.
+    void addSignal(int signal, SignalCallback callback);
+
+    // Runs task on the loop thread. Safe to call from any thread.
+    void post(Callback task);
+
+    // Runs callback once the loop has nothing else to do and no frame is pending.
+    void idle(Callback callback);
+
+    // Asks for a frame callback on the next commit of surface; callback runs
+    // when the compositor reports the frame. The caller must commit right after.
+    void requestFrame(struct wl_surface* surface, Callback callback = {});
+    bool isFramePending() const { return frame != nullptr; }
+
+private:
+    struct Watcher {
+        int fd;
+        FdCallback callback;
+    };
+
+    struct wl_display* display;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int signalFd = -1;
+    bool running = false;
+    bool flushPending = false;
+
+    std::unordered_map<int, std::shared_ptr<Watcher>> watchers;
+    std::unordered_set<int> timers;
+    std::unordered_map<int, SignalCallback> signalCallbacks;
+    std::vector<Callback> idleCallbacks;
+
+    std::mutex postedMutex;
+    std::vector<Callback> posted;
+
+    struct wl_callback* frame = nullptr;
+    std::vector<Callback> frameCallbacks;
+
+    void watch(int fd, uint32_t events, int operation);
+    void flushDisplay();
+    void runPosted();
+    void runSignals();
+    void runIdle();
+
+    static void frameDoneHandler(void* data, struct wl_callback* callback, uint32_t time);
+    static const struct wl_callback_listener frame_listener;
+};
+
+#endif //GWAYTOOL_EVENT_LOOP_H
@@ -0,0 +1,15 @@
+#ifndef GWAYTOOL_FILE_IO_H
+#define GWAYTOOL_FILE_IO_H
+
+#include <cstddef>
+#include <string>
+
+// Writes all of data to fd, retrying short and interrupted writes. False on
+// any other error, with errno set.
+bool writeAll(int fd, const char* data, size_t size);
+
+// Fsyncs the directory holding path, so a file created or renamed there
+// survives a crash. Best effort: errors are ignored.
+void syncParentDirectory(const std::string& path);
+
+#endif //GWAYTOOL_FILE_IO_H
@@ -0,0 +1,37 @@
+#ifndef GWAYTOOL_GEOMETRY_H
+#define GWAYTOOL_GEOMETRY_H
+
+#include <algorithm>
+
+struct Rect {
+    int x = 0, y = 0, width = 0, height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+
+    bool contains(int px, int py) const {
+        return px >= x && px <= x + width && py >= y && py <= y + height;
+    }
+
+    bool intersects(const Rect& other) const {
+        return x < other.x + other.width && other.x < x + width &&
+               y < other.y + other.height && other.y < y + height;
+    }
+
+    Rect united(const Rect& other) const {
+        if (empty()) return other;
+        if (other.empty()) return *this;
+        int left = std::min(x, other.x);
+        int top = std::min(y, other.y);
+        int right = std::max(x + width, other.x + other.width);
+        int bottom = std::max(y + height, other.y + other.height);
+        return {left, top, right - left, bottom - top};
+    }
+
+    Rect inflated(int by) const {
+        return {x - by, y - by, width + 2 * by, height + 2 * by};
+    }
+
+    bool operator==(const Rect& other) const = default;
+};
+
+#endif //GWAYTOOL_GEOMETRY_H
@@ -0,0 +1,30 @@
+#ifndef GWAYTOOL_HEATMAP_RASTER_H
+#define GWAYTOOL_HEATMAP_RASTER_H
+
+#include "dataset.h"
+#include "thread-pool.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+enum class Colormap {
+    Viridis,
+    Inferno,
+    Grayscale,
+};
+
+// 256 opaque ARGB32 colours from the lowest value to the highest, built once.
+const std::array<uint32_t, 256>& colormapTable(Colormap colormap);
+
+// Colours a row major rows x cols matrix into width x height ARGB32 pixels,
+// stride in bytes. A matrix larger than the pixels is reduced to the mean
+// of the block of cells under each pixel, a smaller one is drawn in blocks.
+// Values map linearly from [low, high] onto the colormap, clamped at its
+// ends. Output rows are split across pool.
+template<ChartValue T>
+void renderHeatmap(std::span<const T> values, size_t rows, size_t cols, double low, double high,
+                   Colormap colormap, unsigned char* pixels, int width, int height, int stride,
+                   ThreadPool& pool = ThreadPool::shared());
+
+#endif //GWAYTOOL_HEATMAP_RASTER_H
@@ -0,0 +1,59 @@
+#ifndef GWAYTOOL_HIT_GRID_H
+#define GWAYTOOL_HIT_GRID_H
+
+#include "geometry.h"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+using WidgetId = uint32_t;
+
+// Uniform grid over widget bounds for hit testing. Every cell keeps the
+// widgets overlapping it ordered topmost first, so a lookup only looks at
+// the few widgets sharing the cell under the point.
+// Higher z is on top, for equal z the widget inserted later is.
+// Ids are chosen by the caller and should be small and dense, like pool slots.
+class HitGrid {
+public:
+    explicit HitGrid(int cellSize = 64);
+
+    void insert(WidgetId id, const Rect& bounds, int z = 0);
+    // Only the cells the widget enters or leaves are touched.
+    void move(WidgetId id, const Rect& bounds);
+    void remove(WidgetId id);
+    const Rect& getBounds(WidgetId id) const { return items[id].bounds; }
+
+    // Topmost widget containing the point.
+    std::optional<WidgetId> hitTest(int x, int y) const;
+    // Widgets intersecting area, topmost first.
+    void query(const Rect& area, std::vector<WidgetId>& out) const;
+
+private:
+    struct Item {
+        Rect bounds;
+        int z = 0;
+        uint32_t order = 0;
+        bool alive = false;
+    };
+
+    struct CellRange {
+        int x0, y0, x1, y1;
+
+        bool contains(int cx, int cy) const { return cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1; }
+    };
+
+    int cellSize;
+    std::vector<Item> items;
+    uint32_t nextOrder = 0;
+    std::unordered_map<uint64_t, std::vector<WidgetId>> cells;
+
+    CellRange rangeOf(const Rect& bounds) const;
+    int cellOf(int coordinate) const;
+    static uint64_t key(int cx, int cy);
+    bool above(WidgetId a, WidgetId b) const;
+    void addToCell(int cx, int cy, WidgetId id);
+    void removeFromCell(int cx, int cy, WidgetId id);
+};
+
+#endif //GWAYTOOL_HIT_GRID_H
@@ -0,0 +1,50 @@
+#ifndef GWAYTOOL_HOVER_INDEX_H
+#define GWAYTOOL_HOVER_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+// A value as the chart was given it, integers kept exact.
+using HoverValue = std::variant<int64_t, double>;
+
+// A point a chart drew, where it is on screen and what it stands for.
+struct HoverPoint {
+    float x = 0.0f;
+    float y = 0.0f;
+    HoverValue valueX;
+    HoverValue valueY;
+
+    bool operator==(const HoverPoint& other) const = default;
+};
+
+// Nearest point lookups for chart tooltips. Points are collected as a chart
+// is drawn and kept in a 2-d tree over their screen positions, built on the
+// first lookup after they changed, so charts redrawn while the pointer is
+// elsewhere never pay for the tree. The tree lives in the
+// point array itself: every range holds its median, by x or y in turn, at
+// its middle, the points before it on one side and the points after it on
+// the other.
+class HoverIndex {
+public:
+    void clear();
+    void reserve(size_t count) { points.reserve(count); }
+    void add(const HoverPoint& point);
+
+    // Point nearest to (x, y) no further than radius away, or null.
+    const HoverPoint* nearest(float x, float y, float radius);
+
+    size_t size() const { return points.size(); }
+    bool empty() const { return points.empty(); }
+
+private:
+    std::vector<HoverPoint> points;
+    bool built = false;
+
+    void build(size_t first, size_t last, bool byX);
+    void search(size_t first, size_t last, bool byX, float x, float y, float& bestDistance,
+                const HoverPoint*& best) const;
+};
+
+#endif //GWAYTOOL_HOVER_INDEX_H
@@ -0,0 +1,127 @@
+#ifndef GWAYTOOL_INPLACE_FUNCTION_H
+#define GWAYTOOL_INPLACE_FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, size_t Capacity = 32, bool AllowHeap = false>
+class InplaceFunction;
+
+// Move-only replacement for std::function that keeps the callable in a fixed
+// inline buffer. A callable that does not fit is a compile error unless
+// AllowHeap is set; large state should be captured through a std::shared_ptr
+// so that sharing it is explicit.
+template<typename R, typename... Args, size_t Capacity, bool AllowHeap>
+class InplaceFunction<R(Args...), Capacity, AllowHeap> {
+public:
+    InplaceFunction() = default;
+    InplaceFunction(std::nullptr_t) {
+    }
+
+    template<typename F, typename Stored = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<Stored, InplaceFunction> &&
+                                         std::is_invocable_r_v<R, Stored&, Args...>>>
+    InplaceFunction(F&& callable) {
+        if constexpr (fitsInline<Stored>) {
+            new (storage) Stored(std::forward<F>(callable));
+            ops = &inlineOps<Stored>;
+        } else {
+            static_assert(AllowHeap, "callable does not fit the inline buffer, "
+                                     "capture large data through a std::shared_ptr");
+            new (storage) Stored*(new Stored(std::forward<F>(callable)));
+            ops = &heapOps<Stored>;
+        }
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(other.storage, storage);
+            other.ops = nullptr;
+        }
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) {
+                ops->move(other.storage, storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() {
+        reset();
+    }
+
+    // Throws std::bad_function_call when empty, as std::function does.
+    R operator()(Args... args) const {
+        if (!ops) {
+            throw std::bad_function_call();
+        }
+        return ops->invoke(storage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return ops != nullptr; }
+
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void* storage, Args&&... args);
+        // Move-constructs into to and destroys from.
+        void (*move)(void* from, void* to) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename F>
+    static constexpr bool fitsInline = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+                                       std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    static constexpr Ops inlineOps = {
+            [](void* storage, Args&&... args) -> R {
+                return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+            },
+            [](void* from, void* to) noexcept {
+                new (to) F(std::move(*static_cast<F*>(from)));
+                static_cast<F*>(from)->~F();
+            },
+            [](void* storage) noexcept {
+                static_cast<F*>(storage)->~F();
+            },
+    };
+
+    template<typename F>
+    static constexpr Ops heapOps = {
+            [](void* storage, Args&&... args) -> R {
+                return (**static_cast<F**>(storage))(std::forward<Args>(args)...);
+            },
+            [](void* from, void* to) noexcept {
+                new (to) F*(*static_cast<F**>(from));
+            },
+            [](void* storage) noexcept {
+                delete *static_cast<F**>(storage);
+            },
+    };
+
+    static_assert(AllowHeap ? Capacity >= sizeof(void*) : true, "the heap fallback needs room for a pointer");
+
+    alignas(std::max_align_t) mutable std::byte storage[Capacity];
+    const Ops* ops = nullptr;
+};
+
+#endif //GWAYTOOL_INPLACE_FUNCTION_H
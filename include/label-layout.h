@@ -0,0 +1,69 @@
+#ifndef GWAYTOOL_LABEL_LAYOUT_H
+#define GWAYTOOL_LABEL_LAYOUT_H
+
+#include <cairo/cairo.h>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Label layout for chart axes and slices: ticks at steps people read easily,
+// labels measured once per text, and labels that would overprint dropped, so
+// the text a chart draws is bounded by its size rather than by its data.
+
+// 1, 2 or 5 times a power of ten, the smallest such step cutting span into
+// at most maxSteps steps; 0 for an empty or infinite span.
+double niceStep(double span, size_t maxSteps);
+
+// Multiples of niceStep(high - low, maxSteps) from low to high.
+std::vector<double> niceTicks(double low, double high, size_t maxSteps);
+
+// How a label sits against the point it belongs to.
+enum class LabelAnchor {
+    // Centered, baseline on the point: under an x axis.
+    Baseline,
+    // Ending at the point, centered on it vertically: left of a y axis.
+    Right,
+    // Centered on the point both ways.
+    Center,
+};
+
+// A label on screen: its text is shown from (x, y), the start of its
+// baseline, and its ink lies within the box.
+struct PlacedLabel {
+    std::string text;
+    double x = 0.0, y = 0.0;
+    double left = 0.0, top = 0.0, width = 0.0, height = 0.0;
+
+    // Whether the boxes come closer than gap.
+    bool overlaps(const PlacedLabel& other, double gap) const;
+};
+
+// Drops every label coming closer than gap to one kept before it, so earlier
+// labels win. Kept boxes go into a spatial hash, so each label is only
+// tested against its neighbours.
+void cullOverlapping(std::vector<PlacedLabel>& labels, double gap);
+
+// Extents of chart label text in one font, measured once per text on a
+// scratch context. The cache is emptied when it reaches capacity.
+class TextExtentsCache {
+public:
+    TextExtentsCache(std::string family, double size, size_t capacity = 4096)
+            : family(std::move(family)), size(size), capacity(capacity) {}
+    ~TextExtentsCache();
+
+    TextExtentsCache(const TextExtentsCache&) = delete;
+    TextExtentsCache& operator=(const TextExtentsCache&) = delete;
+
+    const cairo_text_extents_t& measure(const std::string& text);
+    PlacedLabel place(std::string text, double x, double y, LabelAnchor anchor);
+
+private:
+    std::string family;
+    double size;
+    size_t capacity;
+    cairo_t* scratch = nullptr;
+    std::unordered_map<std::string, cairo_text_extents_t> extents;
+};
+
+#endif //GWAYTOOL_LABEL_LAYOUT_H
@@ -0,0 +1,57 @@
+#ifndef GWAYTOOL_LIVE_CHARTS_H
+#define GWAYTOOL_LIVE_CHARTS_H
+
+#include "event-loop.h"
+#include "stream-series.h"
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+class CairoRenderer;
+
+// Redraws charts fed by stream series at most once per frame. A stream with
+// new samples only marks its chart dirty; dirty charts are redrawn together
+// in one batch, right away when no frame is pending and otherwise when the
+// pending frame is done. Everything runs on the loop thread.
+class LiveCharts {
+public:
+    LiveCharts(EventLoop& loop, CairoRenderer& renderer, struct wl_surface* surface);
+    ~LiveCharts();
+
+    LiveCharts(const LiveCharts&) = delete;
+    LiveCharts& operator=(const LiveCharts&) = delete;
+
+    // draw gets the stream's window each time new samples came in. One
+    // subscription per stream; draw may paint several charts from it.
+    template<ChartValue T>
+    void subscribe(std::shared_ptr<StreamSeries<T>> stream, std::function<void(std::span<const T>)> draw) {
+        int fd = stream->getFd();
+        add(fd, [stream] { return stream->drain(); },
+            [stream, draw = std::move(draw)] { draw(stream->window()); });
+    }
+
+    template<ChartValue T>
+    void unsubscribe(const StreamSeries<T>& stream) { remove(stream.getFd()); }
+
+private:
+    struct Subscription {
+        int fd;
+        std::function<size_t()> drain;
+        std::function<void()> draw;
+        bool dirty = false;
+    };
+
+    EventLoop& loop;
+    CairoRenderer& renderer;
+    struct wl_surface* surface;
+    std::vector<Subscription> subscriptions;
+    bool scheduled = false;
+
+    void add(int fd, std::function<size_t()> drain, std::function<void()> draw);
+    void remove(int fd);
+    void onReadable(int fd);
+    void redraw();
+};
+
+#endif //GWAYTOOL_LIVE_CHARTS_H
@@ -0,0 +1,123 @@
+#ifndef GWAYTOOL_LOG_H
+#define GWAYTOOL_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Records below this level are compiled out, arguments included.
+// 0 debug, 1 info, 2 warning, 3 error, 4 nothing.
+#ifndef GWAYTOOL_LOG_LEVEL
+#ifdef NDEBUG
+#define GWAYTOOL_LOG_LEVEL 1
+#else
+#define GWAYTOOL_LOG_LEVEL 0
+#endif
+#endif
+
+// format must be a string literal, "{}" is replaced by the next argument.
+// Integers, floating point numbers, bools and strings are supported.
+#define GWAYTOOL_LOG(level, format, ...)                                                      \
+    do {                                                                                      \
+        if constexpr (static_cast<int>(level) >= GWAYTOOL_LOG_LEVEL) {                        \
+            ::logging::write(level, "" format __VA_OPT__(,) __VA_ARGS__);                     \
+        }                                                                                     \
+    } while (0)
+
+#define LOG_DEBUG(format, ...) GWAYTOOL_LOG(::logging::Level::Debug, format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_INFO(format, ...) GWAYTOOL_LOG(::logging::Level::Info, format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARNING(format, ...) GWAYTOOL_LOG(::logging::Level::Warning, format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(format, ...) GWAYTOOL_LOG(::logging::Level::Error, format __VA_OPT__(,) __VA_ARGS__)
+
+// Records are copied as binary into a lock-free ring owned by the calling
+// thread and formatted by a background thread, so logging never waits for
+// the terminal. A record that does not fit into a full ring is dropped and
+// counted instead of blocking.
+namespace logging {
+
+enum class Level : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error,
+};
+
+enum class ArgType : uint8_t {
+    Int,
+    Unsigned,
+    Double,
+    Bool,
+    String,
+};
+
+// Returns where the caller writes size bytes of record body, or nullptr
+// when the ring is full. commit() publishes what was written.
+std::byte* reserve(Level level, const char* format, uint8_t argCount, size_t size);
+void commit();
+
+// Blocks until everything logged so far has been written out.
+void flush();
+
+namespace detail {
+
+template<typename T>
+constexpr bool isString = std::is_convertible_v<const T&, std::string_view>;
+
+template<typename T>
+size_t encodedSize(const T& value) {
+    if constexpr (isString<T>) {
+        return 1 + sizeof(uint32_t) + std::string_view(value).size();
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return 2;
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "unsupported log argument type");
+        return 1 + 8;
+    }
+}
+
+template<typename T>
+std::byte* encode(std::byte* out, const T& value) {
+    auto put = [&out](ArgType type, const void* data, size_t size) {
+        *out++ = static_cast<std::byte>(type);
+        std::memcpy(out, data, size);
+        out += size;
+    };
+    if constexpr (isString<T>) {
+        std::string_view text(value);
+        auto length = static_cast<uint32_t>(text.size());
+        put(ArgType::String, &length, sizeof(length));
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    } else if constexpr (std::is_same_v<T, bool>) {
+        uint8_t flag = value;
+        put(ArgType::Bool, &flag, 1);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double number = value;
+        put(ArgType::Double, &number, 8);
+    } else if constexpr (std::is_signed_v<T>) {
+        int64_t number = value;
+        put(ArgType::Int, &number, 8);
+    } else {
+        uint64_t number = value;
+        put(ArgType::Unsigned, &number, 8);
+    }
+    return out;
+}
+
+} // namespace detail
+
+template<typename... Args>
+void write(Level level, const char* format, const Args&... args) {
+    size_t size = (size_t{0} + ... + detail::encodedSize(args));
+    std::byte* out = reserve(level, format, static_cast<uint8_t>(sizeof...(Args)), size);
+    if (!out) return;
+    ((out = detail::encode(out, args)), ...);
+    commit();
+}
+
+} // namespace logging
+
+#endif //GWAYTOOL_LOG_H
@@ -1,10 +1,27 @@
 #ifndef GWAYTOOL_RENDERER_H
 #define GWAYTOOL_RENDERER_H
 #include "context.h"
+#include "chart-layers.h"
 #include "text-field.h"
+#include "hit-grid.h"
+#include "widget-pool.h"
+#include "dataset.h"
+#include "decimate.h"
+#include "series-pyramid.h"
+#include "scatter-raster.h"
+#include "heatmap-raster.h"
+#include "hover-index.h"
+#include "label-layout.h"
 #include <optional>
+#include <ranges>
+#include <span>
 #pragma once
 
+template<std::ranges::contiguous_range Values>
+auto spanOf(const Values& values) {
+    return std::span<const std::ranges::range_value_t<Values>>(std::ranges::data(values), std::ranges::size(values));
+}
+
 class CairoRenderer {
 public:
     CairoRenderer(MyEGLContext& egl, EGLSurface egl_surface);
@@ -12,27 +29,126 @@ public:
 
     void drawText(const std::string& text, int x, int y, double r, double g, double b, int size);
     void drawImage(const std::string& imagePath, int x, int y, double scaleX, double scaleY);
-    void addButton(Button button) {
-        std::cout << "checking move" << std::endl;
-        buttons.emplace_back(std::move(button));
-    }
+    WidgetHandle addButton(Button button);
+    void removeWidget(WidgetHandle handle);
 
+    // Topmost widget at the point. The text input takes part once it is drawn
+    // and stays above the buttons.
+    std::optional<WidgetHandle> widgetAt(int x, int y) const;
+    bool isTextInput(WidgetHandle handle) const { return textInputWidget == handle; }
+    const HitGrid& getHitGrid() const { return hitGrid; }
+    const WidgetPool& getWidgets() const { return widgets; }
 
     void handleClick(int x, int y);
+    // Runs the widget's callback, if it has one.
+    void clickWidget(WidgetHandle handle);
     void drawButton();
     void drawTextInput(const TextInput &textInput);
+    // Repaints only the part of textInput inside area.
+    void drawTextInputRegion(const TextInput &textInput, const Rect& area);
+    // Clears the area textInput was dragged away from and draws it again, in one swap.
+    void drawMovedTextInput(const TextInput &textInput, const Rect& previous);
     void clearArea(int x, int y, int width, int height);
-    void drawBarChart(const std::vector<int>& values, int x, int y, int width, int height,
+    // Draw calls between these share one swap at endBatch, so redrawing many
+    // charts for a frame shows them together. Batches may nest.
+    void beginBatch() { batchDepth++; }
+    void endBatch();
+    // Charts take any contiguous range of ChartValue: vectors, spans and
+    // datasets are drawn straight from their buffers.
+    template<ChartValue T>
+    void drawBarChart(std::span<const T> values, int x, int y, int width, int height,
                       double r, double g, double b,
                       const std::optional<std::vector<std::string>>& optionalLabels = std::nullopt,
                       const std::optional<std::string> &title = std::nullopt);
-    void drawLineChart(const std::vector<int>& x_values, const std::vector<int>& y_values, int x, int y, int width, int height,
+    template<std::ranges::contiguous_range Values>
+        requires ChartValue<std::ranges::range_value_t<Values>>
+    void drawBarChart(const Values& values, int x, int y, int width, int height,
+                      double r, double g, double b,
+                      const std::optional<std::vector<std::string>>& optionalLabels = std::nullopt,
+                      const std::optional<std::string> &title = std::nullopt) {
+        drawBarChart(spanOf(values), x, y, width, height, r, g, b, optionalLabels, title);
+    }
+
+    template<ChartValue X, ChartValue Y>
+    void drawLineChart(std::span<const X> x_values, std::span<const Y> y_values, int x, int y, int width, int height,
                                       double r, double g, double b,
-                                      const std::optional<std::string> &title);
-    void drawPieChart(const std::vector<int>& values, int x, int y, int radius,
+                                      const std::optional<std::string> &title,
+                                      Decimation decimation = Decimation::MinMax);
+    template<std::ranges::contiguous_range XValues, std::ranges::contiguous_range YValues>
+        requires ChartValue<std::ranges::range_value_t<XValues>> &&
+                 ChartValue<std::ranges::range_value_t<YValues>>
+    void drawLineChart(const XValues& x_values, const YValues& y_values, int x, int y, int width, int height,
+                       double r, double g, double b,
+                       const std::optional<std::string> &title,
+                       Decimation decimation = Decimation::MinMax) {
+        drawLineChart(spanOf(x_values), spanOf(y_values), x, y, width, height, r, g, b, title, decimation);
+    }
+
+    // Samples [first, last) of series across the chart, for zooming and
+    // panning through long series; reads pyramid buckets, not samples.
+    template<ChartValue Y>
+    void drawLineChart(const SeriesPyramid<Y>& series, size_t first, size_t last, int x, int y, int width, int height,
+                       double r, double g, double b,
+                       const std::optional<std::string> &title);
+
+    // Points (x_values[i], y_values[i]) rasterized into one image, for
+    // clouds far too large for a path per point.
+    template<ChartValue X, ChartValue Y>
+    void drawScatterChart(std::span<const X> x_values, std::span<const Y> y_values, int x, int y, int width, int height,
+                          double r, double g, double b,
+                          const std::optional<std::string> &title,
+                          ScatterMode mode = ScatterMode::Density);
+    template<std::ranges::contiguous_range XValues, std::ranges::contiguous_range YValues>
+        requires ChartValue<std::ranges::range_value_t<XValues>> &&
+                 ChartValue<std::ranges::range_value_t<YValues>>
+    void drawScatterChart(const XValues& x_values, const YValues& y_values, int x, int y, int width, int height,
+                          double r, double g, double b,
+                          const std::optional<std::string> &title,
+                          ScatterMode mode = ScatterMode::Density) {
+        drawScatterChart(spanOf(x_values), spanOf(y_values), x, y, width, height, r, g, b, title, mode);
+    }
+
+    // A rows x cols matrix, row major, coloured from its smallest value to
+    // its largest, with a colour bar at the right edge of the given width.
+    // Labels are thinned out where rows or columns are too narrow for all of
+    // them.
+    template<ChartValue T>
+    void drawHeatmap(std::span<const T> values, size_t rows, size_t cols, int x, int y, int width, int height,
+                     const std::optional<std::vector<std::string>>& rowLabels,
+                     const std::optional<std::vector<std::string>>& columnLabels,
+                     const std::optional<std::string>& title,
+                     Colormap colormap = Colormap::Viridis);
+    template<std::ranges::contiguous_range Values>
+        requires ChartValue<std::ranges::range_value_t<Values>>
+    void drawHeatmap(const Values& values, size_t rows, size_t cols, int x, int y, int width, int height,
+                     const std::optional<std::vector<std::string>>& rowLabels,
+                     const std::optional<std::vector<std::string>>& columnLabels,
+                     const std::optional<std::string>& title,
+                     Colormap colormap = Colormap::Viridis) {
+        drawHeatmap(spanOf(values), rows, cols, x, y, width, height, rowLabels, columnLabels, title, colormap);
+    }
+
+    template<ChartValue T>
+    void drawPieChart(std::span<const T> values, int x, int y, int radius,
                                      const std::vector<std::tuple<double, double, double>>& colors,
                                      const std::optional<std::vector<std::string>>& optionalLabels,
                                      const std::optional<std::string>& title);
+    template<std::ranges::contiguous_range Values>
+        requires ChartValue<std::ranges::range_value_t<Values>>
+    void drawPieChart(const Values& values, int x, int y, int radius,
+                      const std::vector<std::tuple<double, double, double>>& colors,
+                      const std::optional<std::vector<std::string>>& optionalLabels,
+                      const std::optional<std::string>& title) {
+        drawPieChart(spanOf(values), x, y, radius, colors, optionalLabels, title);
+    }
+
+    // Tooltips for the points of line and scatter charts. updateHover looks
+    // up the point nearest to (x, y) and returns whether the tooltip changes
+    // for it; drawTooltip then shows it without redrawing anything. The
+    // tooltip is drawn over each frame as it is swapped to the screen and
+    // taken off right after, so draw calls never paint under it.
+    bool updateHover(int x, int y);
+    void drawTooltip();
 
     void drawLine(int x1, int y1, int x2, int y2, double r, double g, double b, double lineWidth);
     void drawTable(const std::vector<std::vector<std::string>>& data,
@@ -46,8 +162,50 @@ private:
     cairo_device_t* cairo_device;
     cairo_surface_t* cairo_surface;
     cairo_t* cairo_context;
-    std::vector<Button> buttons;
+    WidgetPool widgets;
+    // Ids in the grid are pool slots.
+    HitGrid hitGrid;
+    std::optional<WidgetHandle> textInputWidget;
+
+    // Keeps the text input's grid entry in line with where it is painted.
+    void trackTextInput(const TextInput& textInput);
+    // Swaps buffers, or leaves that to endBatch inside a batch.
+    void present();
+    // The swap itself, with the tooltip over the frame.
+    void swapBuffers();
+    int batchDepth = 0;
+    bool swapDeferred = false;
+    // Axes, ticks, labels and titles of recently drawn charts.
+    ChartLayerCache chartLayers;
+    // Extents of chart labels, which are all Arial at 12.
+    TextExtentsCache labelExtents{"Arial", 12};
+    ScatterRaster scatterRaster;
+    // Pixels of the rasterized charts, kept while their size stays the same.
+    cairo_surface_t* chartImage = nullptr;
+    // chartImage at width x height, flushed for writing its pixels.
+    cairo_surface_t* chartImageFor(int width, int height);
     double bg_r = 0.5, bg_g = 0.5, bg_b = 0.5;
+
+    // Points of the line and scatter charts on screen, by chart area.
+    struct HoverTarget {
+        Rect area;
+        HoverIndex points;
+    };
+    std::vector<HoverTarget> hoverTargets;
+    // The emptied index of the chart at area, dropping those it covers.
+    HoverIndex& hoverTargetFor(const Rect& area);
+    void forgetHoverTargets(const Rect& area);
+    std::optional<HoverPoint> pointNear(int x, int y);
+    // Last pointer position, -1 when it is not over the surface, and the point under it.
+    int hoverX = -1, hoverY = -1;
+    std::optional<HoverPoint> hovered;
+    // Charts were drawn or cleared since hovered was looked up.
+    bool hoverTargetsChanged = false;
+    // Where the tooltip is, empty while hidden, and the pixels it covers.
+    Rect tooltipBounds;
+    cairo_surface_t* tooltipUnder = nullptr;
+    void hideTooltip(cairo_t* cr);
+    void showTooltip(cairo_t* cr);
 };
 
 
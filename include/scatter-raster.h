@@ -0,0 +1,67 @@
+#ifndef GWAYTOOL_SCATTER_RASTER_H
+#define GWAYTOOL_SCATTER_RASTER_H
+
+#include "dataset.h"
+#include "thread-pool.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class ScatterMode {
+    // Every pixel holding a point in the full colour.
+    Solid,
+    // Opacity grows with the points per pixel, on a log scale up to the densest pixel.
+    Density,
+};
+
+// Rasterizes point clouds straight into pixels, without paths: points are
+// mapped to pixels with the chart kernels and counted per pixel, then the
+// counts are tone mapped to colours. Points are split across the pool, each
+// chunk counting into its own grid, and the grids are merged and tone
+// mapped in parallel row tiles.
+class ScatterRaster {
+public:
+    explicit ScatterRaster(ThreadPool& pool = ThreadPool::shared()) : pool(pool) {}
+
+    // Clears the counts and maps [xMin, xMax] x [yMin, yMax] onto width x
+    // height pixels, y growing upwards. Points outside are skipped.
+    void reset(int width, int height, double xMin, double xMax, double yMin, double yMax);
+
+    // Counts the points (x_values[i], y_values[i]); both must be as long.
+    template<ChartValue X, ChartValue Y>
+    void add(std::span<const X> x_values, std::span<const Y> y_values);
+
+    // Writes premultiplied ARGB32 pixels, as cairo image surfaces hold them;
+    // stride is in bytes.
+    void toneMap(ScatterMode mode, double r, double g, double b, unsigned char* pixels, int stride) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Points in the densest pixel.
+    uint32_t getMaxCount() const { return maxCount; }
+    // Index of the first point counted into each pixel, in the points of the
+    // add call that first reached it; noPoint for empty pixels. Points on
+    // one pixel look alike, so one stands for all of them when hovering.
+    const std::vector<size_t>& getFirstPoints() const { return firstPoints; }
+    static constexpr size_t noPoint = static_cast<size_t>(-1);
+
+private:
+    ThreadPool& pool;
+    int width = 0;
+    int height = 0;
+    double xScale = 0.0, xOffset = 0.0;
+    double yScale = 0.0, yOffset = 0.0;
+    std::vector<uint32_t> counts;
+    std::vector<size_t> firstPoints;
+    uint32_t maxCount = 0;
+    // One count and first point grid per chunk of points, merged into
+    // counts and firstPoints after each add. First points are offsets from
+    // the chunk's first point, only set where the chunk's count is not 0, so
+    // the grid is never cleared.
+    std::vector<std::vector<uint32_t>> partials;
+    std::vector<std::vector<uint32_t>> partialFirsts;
+
+    void merge(size_t chunks, size_t count);
+};
+
+#endif //GWAYTOOL_SCATTER_RASTER_H
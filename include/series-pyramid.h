@@ -0,0 +1,58 @@
+#ifndef GWAYTOOL_SERIES_PYRAMID_H
+#define GWAYTOOL_SERIES_PYRAMID_H
+
+#include "dataset.h"
+#include "thread-pool.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Min/max summary of a growing series for zooming and panning. Level l holds
+// one bucket per 2^(baseLevel + l) samples, so any window can be reduced to a
+// few points per pixel column by reading whole buckets instead of samples.
+template<ChartValue T>
+class SeriesPyramid {
+public:
+    // Windows with fewer samples per column than a base bucket read samples.
+    static constexpr unsigned baseLevel = 4;
+
+    // Shares samples' buffer; the levels are built on pool.
+    explicit SeriesPyramid(Dataset<T> samples, ThreadPool& pool = ThreadPool::shared());
+
+    // Adds samples at the end, updating only the buckets they fall into.
+    void append(std::span<const T> samples);
+
+    size_t size() const { return base.size() + tail.size(); }
+    T at(size_t index) const { return index < base.size() ? base[index] : tail[index - base.size()]; }
+    // Changes with every append.
+    uint64_t getVersion() const { return version; }
+
+    // Appends the indices to draw for samples [first, last) across columns
+    // pixels: first, minimum, maximum and last sample of every column, in
+    // increasing order. Column edges are snapped to bucket edges, so each
+    // column reads a few buckets and the cost depends on columns only.
+    void window(size_t first, size_t last, size_t columns, std::vector<size_t>& out) const;
+
+    // Smallest and largest sample in [first, last), which must not be empty.
+    std::pair<T, T> range(size_t first, size_t last) const;
+
+private:
+    struct Bucket {
+        size_t minIndex;
+        size_t maxIndex;
+        T minValue;
+        T maxValue;
+    };
+
+    ThreadPool& pool;
+    Dataset<T> base;
+    std::vector<T> tail;
+    std::vector<std::vector<Bucket>> levels;
+    uint64_t version;
+
+    // Recomputes every bucket containing a sample from fromSample on.
+    void update(size_t fromSample);
+    Bucket extremes(size_t first, size_t last) const;
+};
+
+#endif //GWAYTOOL_SERIES_PYRAMID_H
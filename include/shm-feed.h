@@ -0,0 +1,149 @@
+#ifndef GWAYTOOL_SHM_FEED_H
+#define GWAYTOOL_SHM_FEED_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+// Shared memory feed of double samples from a writer process to readers.
+// Segment layout, which writers in other languages have to follow:
+//
+//   ShmFeedHeader                         (128 bytes)
+//   slotCount slots, each slotStride bytes:
+//     ShmFeedSlot                         (16 bytes)
+//     samplesPerSlot little endian doubles
+//
+// Slot n of the stream lives at index n % slotCount. The writer marks it odd
+// (2n + 1) in sequence, fills it, marks it complete (2n + 2), and then raises
+// published to n + 1. Writers never wait for readers; a reader that falls
+// more than slotCount behind loses the oldest slots.
+
+constexpr uint32_t shmFeedMagic = 0x46545747; // "GWTF"
+constexpr uint32_t shmFeedVersion = 1;
+
+struct ShmFeedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount; // power of two
+    uint32_t samplesPerSlot;
+    uint32_t slotStride; // bytes, a multiple of 64
+    uint32_t reserved[11];
+    alignas(64) std::atomic<uint64_t> published;
+};
+
+struct ShmFeedSlot {
+    std::atomic<uint64_t> sequence;
+    uint32_t count; // samples used, at most samplesPerSlot
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ShmFeedHeader) == 128 && sizeof(ShmFeedSlot) == 16);
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the feed needs address free 64-bit atomics");
+
+// Creates and owns a feed segment.
+class ShmFeedWriter {
+public:
+    // name is a POSIX shm name such as "/gwaytool-feed"; an empty name makes
+    // an anonymous memfd, to be handed to the reader through getFd().
+    ShmFeedWriter(const std::string& name, uint32_t slotCount, uint32_t samplesPerSlot);
+    ~ShmFeedWriter();
+
+    ShmFeedWriter(const ShmFeedWriter&) = delete;
+    ShmFeedWriter& operator=(const ShmFeedWriter&) = delete;
+
+    // Publishes samples, samplesPerSlot per slot. Never blocks.
+    void write(std::span<const double> samples);
+    int getFd() const { return fd; }
+
+private:
+    std::string name;
+    int fd = -1;
+    void* base = nullptr;
+    size_t size = 0;
+    ShmFeedHeader* header = nullptr;
+    uint64_t next = 0;
+};
+
+// Maps a feed read-only and hands out its samples, a slot at a time.
+class ShmFeedReader {
+public:
+    explicit ShmFeedReader(const std::string& name);
+    // Maps the segment behind fd, which the caller keeps owning.
+    explicit ShmFeedReader(int fd);
+    ~ShmFeedReader();
+
+    ShmFeedReader(const ShmFeedReader&) = delete;
+    ShmFeedReader& operator=(const ShmFeedReader&) = delete;
+
+    // Calls consume with the samples of every slot published since the last
+    // poll and returns how many samples that was. Each slot is copied out of
+    // the mapping and only handed on once its sequence shows the writer left
+    // it alone meanwhile; a slot reused during the copy would mix two writes,
+    // so it is dropped and counted in getTorn().
+    template<typename Consume>
+    size_t poll(Consume&& consume);
+
+    // Slots overwritten before they were read.
+    uint64_t getLost() const { return lost; }
+    uint64_t getTorn() const { return torn; }
+
+private:
+    const void* base = nullptr;
+    size_t size = 0;
+    const ShmFeedHeader* header = nullptr;
+    // Layout read once and validated by map(); the writer could change the
+    // header afterwards, so only these are used to index the mapping.
+    uint32_t slotCount = 0;
+    uint32_t samplesPerSlot = 0;
+    uint32_t slotStride = 0;
+    // One slot's samples, copied out before they are checked and passed on.
+    std::vector<double> staging;
+    uint64_t next = 0;
+    uint64_t lost = 0;
+    uint64_t torn = 0;
+
+    void map(int fd);
+    const ShmFeedSlot* slotAt(uint64_t sequence) const {
+        size_t index = sequence & (slotCount - 1);
+        return reinterpret_cast<const ShmFeedSlot*>(static_cast<const std::byte*>(base) + sizeof(ShmFeedHeader) +
+                                                    index * slotStride);
+    }
+};
+
+template<typename Consume>
+size_t ShmFeedReader::poll(Consume&& consume) {
+    uint64_t published = header->published.load(std::memory_order_acquire);
+    if (published - next > slotCount) {
+        lost += published - slotCount - next;
+        next = published - slotCount;
+    }
+
+    size_t samples = 0;
+    for (; next < published; ++next) {
+        const ShmFeedSlot* slot = slotAt(next);
+        uint64_t complete = 2 * next + 2;
+        if (slot->sequence.load(std::memory_order_acquire) != complete) {
+            lost++;
+            continue;
+        }
+
+        uint32_t count = std::min(slot->count, samplesPerSlot);
+        std::memcpy(staging.data(), slot + 1, count * sizeof(double));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != complete) {
+            torn++;
+            continue;
+        }
+        consume(std::span<const double>(staging.data(), count));
+        samples += count;
+    }
+    return samples;
+}
+
+#endif //GWAYTOOL_SHM_FEED_H
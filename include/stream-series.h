@@ -0,0 +1,60 @@
+#ifndef GWAYTOOL_STREAM_SERIES_H
+#define GWAYTOOL_STREAM_SERIES_H
+
+#include "dataset.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Live series fed by one producer thread and read by the loop thread.
+// Samples pass through a lock-free ring: the producer never blocks or
+// allocates, and when the reader falls a whole ring behind, new samples are
+// dropped and counted. The reader keeps the most recent samples as a
+// contiguous window for the charts.
+template<ChartValue T>
+class StreamSeries {
+public:
+    // capacity is rounded up to a power of two; history is the window size.
+    explicit StreamSeries(size_t capacity = 1 << 16, size_t history = 4096);
+    ~StreamSeries();
+
+    StreamSeries(const StreamSeries&) = delete;
+    StreamSeries& operator=(const StreamSeries&) = delete;
+
+    // Producer side. Returns how many samples fitted.
+    bool push(T sample) { return push(std::span<const T>(&sample, 1)) == 1; }
+    size_t push(std::span<const T> samples);
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Reader side. The eventfd turns readable when samples arrive after the
+    // last drain; the reader clears it by reading.
+    int getFd() const { return eventFd; }
+    // Moves the samples that arrived into the window, returns how many.
+    size_t drain();
+    // Up to history most recent samples, oldest first. Valid until the next drain.
+    std::span<const T> window() const;
+    // Samples drained so far, the index after the window's last sample.
+    uint64_t getReceived() const { return received; }
+
+private:
+    const size_t mask;
+    std::unique_ptr<T[]> ring;
+    alignas(64) std::atomic<size_t> head{0}; // written by the producer
+    alignas(64) std::atomic<size_t> tail{0}; // written by the reader
+    alignas(64) std::atomic<bool> signalled{false};
+    std::atomic<uint64_t> dropped{0};
+    int eventFd = -1;
+
+    // Twice the window, so the window slides by appending and only moves
+    // back to the front once per history samples.
+    size_t history;
+    std::vector<T> windowBuffer;
+    size_t windowEnd = 0;
+    uint64_t received = 0;
+
+    void appendToWindow(const T* samples, size_t count);
+};
+
+#endif //GWAYTOOL_STREAM_SERIES_H
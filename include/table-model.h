@@ -0,0 +1,49 @@
+#ifndef GWAYTOOL_TABLE_MODEL_H
+#define GWAYTOOL_TABLE_MODEL_H
+
+#include "dataset.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <vector>
+
+// Immutable table of text cells, as read from a CSV file. Numeric columns are
+// parsed on first use and cached, so every chart of a column shares one buffer.
+class TableModel {
+public:
+    using Row = std::vector<std::string>;
+
+    TableModel() = default;
+    explicit TableModel(std::vector<Row> rows);
+
+    const std::vector<Row>& getRows() const { return rows; }
+    size_t rowCount() const { return rows.size(); }
+    size_t columnCount() const { return rows.empty() ? 0 : rows[0].size(); }
+
+    // Cells of column from firstRow on, read as numbers; missing cells and
+    // cells that are not a number read as 0. Defined for int and double.
+    template<typename T>
+    Dataset<T> column(size_t index, size_t firstRow = 0) const;
+
+    // Cells of a categorical column from firstRow on as codes into names,
+    // numbered in order of first appearance. Cached like numeric columns.
+    struct Categories {
+        Dataset<int32_t> codes;
+        std::vector<std::string> names;
+    };
+    Categories categories(size_t index, size_t firstRow = 0) const;
+
+private:
+    struct CachedColumn {
+        std::shared_ptr<const void> buffer;
+        uint64_t version = 0;
+    };
+
+    std::vector<Row> rows;
+    mutable std::mutex columnsLock;
+    mutable std::map<std::tuple<size_t, size_t, std::type_index>, CachedColumn> columns;
+};
+
+#endif //GWAYTOOL_TABLE_MODEL_H
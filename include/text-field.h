@@ -10,118 +10,120 @@
 #include <cstring>
 #include <cstdlib>
 #include <optional>
+#include <string_view>
 #include <xdg-shell-client-protocol.h>
 #include <linux/input-event-codes.h>
 #include "application.h"
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
-#include "fstream"
+#include "text-persistence.h"
+#include "geometry.h"
+
+struct KeyModifiers {
+    bool shift = false;
+    bool ctrl = false;
+};
+
+// One wrapped line of a TextInput. stops are the byte offsets (relative to
+// start) where the caret may sit, xs the pen position of each of them, so
+// hit testing is a binary search instead of measuring text again.
+struct TextLine {
+    size_t start = 0;
+    size_t end = 0;
+    bool startsParagraph = true;
+    std::vector<uint32_t> stops = {0};
+    std::vector<float> xs = {0};
+};
 
 struct TextInput {
     int x, y, width, height;
     bool isFocused = false;
     int lineHeight = 20;
-    std::vector<std::string> lines = {""};
-    std::ofstream textFile;
-
-    TextInput(int x, int y, int width, int height, std::optional<std::string> filePath = std::nullopt)
-            : x(x), y(y), width(width), height(height) {
-        std::string outputPath = filePath.value_or("output.txt");
-        textFile.open(outputPath, std::ios::out | std::ios::trunc);
-        if (!textFile.is_open()) {
-            throw std::runtime_error("Can't open file");
-        }
-    }
-    ~TextInput() {
-        if (textFile.is_open()) {
-            textFile.close();
-        }}
+    static constexpr double fontSize = 14;
+    static constexpr int padding = 10;
+
+    // The document, '\n' separates paragraphs, lines is its wrapped layout.
+    std::string text;
+    std::vector<TextLine> lines = {TextLine{}};
+    // Selection runs between anchor and caret, both are byte offsets.
+    size_t caret = 0;
+    size_t anchor = 0;
+    TextPersistence persistence;
+
+    // Picks up the document a previous run left in the journal of filePath.
+    TextInput(int x, int y, int width, int height, std::optional<std::string> filePath = std::nullopt,
+              PersistenceOptions persistenceOptions = {});
 
     bool contains(int px, int py) const {
         return px >= x && px <= x + width && py >= y && py <= y + height;
     }
 
-    void draw(cairo_t* cr) const {
-        cairo_set_source_rgb(cr, isFocused ? 0.8 : 0.9, 0.9, 0.9);
-        cairo_rectangle(cr, x, y, width, height);
-        cairo_fill(cr);
-
-        cairo_set_source_rgb(cr, 0, 0, 0);
-        cairo_rectangle(cr, x, y, width, height);
-        cairo_stroke(cr);
-
-        cairo_set_source_rgb(cr, 0, 0, 0);
-        for (size_t i = 0; i < lines.size(); ++i) {
-            cairo_move_to(cr, x + 10, y + (i + 1) * lineHeight - 5);
-            cairo_show_text(cr, lines[i].c_str());
-        }
+    void draw(cairo_t* cr) const;
+    void handleKeyPress(uint32_t keysym, KeyModifiers modifiers = {});
+    // Places the caret at the point closest to (px, py), extending the
+    // selection if asked to.
+    void handleClick(int px, int py, bool extendSelection = false);
+
+    void insert(size_t offset, std::string_view bytes);
+    void erase(size_t offset, size_t length);
+    void replaceSelection(std::string_view bytes);
+
+    // Streaming insert at the caret for large pastes. Chunks are appended
+    // straight into text and the paragraphs are wrapped once, in
+    // endBulkInsert(), which also journals the whole insert as one edit.
+    // Other edits are ignored until it ends.
+    void beginBulkInsert();
+    void appendBulk(std::string_view chunk);
+    void endBulkInsert();
+    bool isBulkInserting() const { return bulkStart.has_value(); }
+    void insertBulk(std::string_view bytes) {
+        beginBulkInsert();
+        appendBulk(bytes);
+        endBulkInsert();
     }
 
-    void handleKeyPress(uint32_t keysym) {
-        if (keysym == XKB_KEY_BackSpace) {
-            if (!lines.empty() && !lines.back().empty()) {
-                lines.back().pop_back();
-            } else if (lines.size() > 1) {
-                lines.pop_back();
-            }
-        } else if (keysym == XKB_KEY_Return) {
-            lines.push_back("");
-        } else {
-            char buffer[8];
-            int size = xkb_keysym_to_utf8(keysym, buffer, sizeof(buffer));
-            if (size > 0) {
-                buffer[size] = '\0';
-                lines.back() += buffer;
-
-                auto cr = cairo_create(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1));
-                cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-                cairo_set_font_size(cr, 14);
-                cairo_text_extents_t extents;
-                cairo_text_extents(cr, lines.back().c_str(), &extents);
-                cairo_destroy(cr);
-
-                if (extents.width > width - 20) {
-                    std::string overflow = lines.back();
-                    size_t cutPoint = lines.back().size() - 1;
-                    while (cutPoint > 0) {
-                        cairo_text_extents(cr, lines.back().substr(0, cutPoint).c_str(), &extents);
-                        if (extents.width <= width - 20) {
-                            break;
-                        }
-                        cutPoint--;
-                    }
-                    lines.back() = lines.back().substr(0, cutPoint);
-                    lines.push_back(overflow.substr(cutPoint));
-                }
-            }
-        }
+    bool hasSelection() const { return caret != anchor; }
+    size_t selectionStart() const { return std::min(caret, anchor); }
+    size_t selectionEnd() const { return std::max(caret, anchor); }
+    void moveCaret(size_t offset, bool extendSelection);
 
-        height = std::max(40, static_cast<int>(lines.size() * lineHeight));
+    size_t lineAt(size_t offset) const;
+    size_t offsetAt(int px, int py) const;
+    // Area covered by the caret and the selection, what needs repainting
+    // when only they change.
+    Rect getCaretBounds() const;
+    // Bumped by every edit of the text.
+    uint64_t getRevision() const { return revision; }
 
-        if (textFile.is_open()) {
-            textFile.seekp(0, std::ios::beg);
-            textFile.clear();
-            for (const auto& line : lines) {
-                textFile << line << std::endl;
-            }
-            textFile.flush();
-        }
-    }
+    std::string getInputText() const;
 
-    std::string getInputText() const {
-        std::string input;
-        for (const auto& line : lines) {
-            input += line;
+    void setFocused(bool focused) {
+        if (isFocused && !focused) {
+            persistence.flush();
         }
-        return input;
+        isFocused = focused;
     }
 
-
     void setX(int x);
     void setY(int x);
     int getX() const;
     int getY()const;
 
+private:
+    uint64_t revision = 0;
+    // Caret x kept while moving up and down across lines of different length.
+    std::optional<float> preferredX;
+    // While bulk inserting, the text after the caret is parked in bulkTail.
+    std::optional<size_t> bulkStart;
+    std::string bulkTail;
+
+    size_t stopIndex(const TextLine& line, size_t offset) const;
+    float caretX(size_t offset) const;
+    size_t previousStop(size_t offset) const;
+    size_t nextStop(size_t offset) const;
+    // Re-wraps the paragraphs touched by replacing removed bytes at offset
+    // with inserted bytes; text already holds the result.
+    void relayout(size_t offset, size_t removed, size_t inserted);
 };
 
 #endif //GWAYTOOL_TEXT_FIELD_H
@@ -0,0 +1,90 @@
+#ifndef GWAYTOOL_TEXT_PERSISTENCE_H
+#define GWAYTOOL_TEXT_PERSISTENCE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "edit-journal.h"
+
+// When the writer calls fdatasync().
+enum class Durability {
+    None,       // never, leave it to the kernel writeback
+    OnFlush,    // on flush() and when the writer shuts down
+    EveryWrite  // after every journal append and every write
+};
+
+struct PersistenceOptions {
+    // The plain text file is rewritten once typing has paused for quietPeriod,
+    // but pending changes are never held back for longer than maxDelay or
+    // maxPendingEdits. Edits themselves go to the journal right away.
+    std::chrono::milliseconds quietPeriod{250};
+    std::chrono::milliseconds maxDelay{2000};
+    size_t maxPendingEdits = 256;
+    Durability durability = Durability::OnFlush;
+    // Journal size after which it is folded into a new snapshot.
+    size_t compactAfterBytes = 1 << 20;
+};
+
+// Saves a text document from a background writer thread.
+// The UI thread only queues EditOps. The writer appends them to an
+// EditJournal (<path>.journal / <path>.snapshot), replays them onto its own
+// copy of the document and, debounced, writes that copy to "<path>.tmp" and
+// renames it over <path>, so readers never see a half written file.
+class TextPersistence {
+public:
+    // Recovers the document left by a previous run from the journal.
+    explicit TextPersistence(std::string path, PersistenceOptions options = {});
+    ~TextPersistence();
+
+    TextPersistence(const TextPersistence&) = delete;
+    TextPersistence& operator=(const TextPersistence&) = delete;
+
+    // Never blocks on disk. Assigns the edit its sequence number.
+    void record(EditOp op);
+    // Durability point: writes what is pending and syncs it unless the
+    // policy is Durability::None. Does not wait for the write to finish.
+    void flush();
+
+    // The document rebuilt at startup, moved out on the first call.
+    std::string takeRecoveredDocument() { return std::move(recoveredDocument); }
+    const std::string& getPath() const { return path; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string path;
+    std::string tmpPath;
+    PersistenceOptions options;
+    std::string recoveredDocument;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::vector<EditOp> pendingOps;
+    uint64_t lastSequence = 0;
+    bool flushRequested = false;
+    bool stopping = false;
+
+    // Only touched by the writer thread.
+    EditJournal journal;
+    std::string document;
+    uint64_t documentSequence = 0;
+    bool exportPending = false;
+    size_t editsSinceExport = 0;
+    Clock::time_point firstPendingAt;
+    Clock::time_point lastEditAt;
+    bool unsyncedWrite = false;
+
+    std::thread writer;
+
+    void writerLoop();
+    Clock::time_point exportDeadline() const;
+    bool writeDocument(bool sync);
+    void syncWritten();
+};
+
+#endif //GWAYTOOL_TEXT_PERSISTENCE_H
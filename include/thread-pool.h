@@ -0,0 +1,69 @@
+#ifndef GWAYTOOL_THREAD_POOL_H
+#define GWAYTOOL_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops. The thread calling
+// parallelFor works on its own loop too, so loops may nest without
+// starving the pool.
+class ThreadPool {
+public:
+    // 0 picks one worker less than the hardware threads, the caller being the last.
+    explicit ThreadPool(unsigned workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool shared by the charts, created on first use.
+    static ThreadPool& shared();
+
+    // Threads a loop runs on, counting the caller.
+    size_t concurrency() const { return workers.size() + 1; }
+
+    // Calls body(begin, end) for consecutive ranges of at most grain indices
+    // covering [0, count), and returns once all of them finished. The first
+    // exception thrown by body is rethrown here.
+    template<typename Body>
+    void parallelFor(size_t count, size_t grain, Body&& body) {
+        using Stored = std::remove_reference_t<Body>;
+        run(count, grain, [](void* context, size_t begin, size_t end) {
+            (*static_cast<Stored*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&body)));
+    }
+
+private:
+    struct Job {
+        void (*body)(void* context, size_t begin, size_t end);
+        void* context;
+        size_t count;
+        size_t grain;
+        size_t chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        // Workers inside runChunks, guarded by lock.
+        size_t users = 0;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable jobDone;
+    std::deque<Job*> jobs;
+    bool stopping = false;
+
+    void run(size_t count, size_t grain, void (*body)(void*, size_t, size_t), void* context);
+    void runChunks(Job& job);
+    void workerLoop();
+};
+
+#endif //GWAYTOOL_THREAD_POOL_H
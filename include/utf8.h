@@ -0,0 +1,20 @@
+#ifndef GWAYTOOL_UTF8_H
+#define GWAYTOOL_UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Decodes the UTF-8 sequence at text[i] and returns its length in bytes.
+// A malformed byte decodes to 0x80000000 | byte with length 1, so callers
+// always make progress and never split what follows.
+size_t decodeUtf8(std::string_view text, size_t i, uint32_t& codepoint);
+
+// Appends the end offset of every extended grapheme cluster in text, so a
+// caret stepping through the result never lands inside a multibyte sequence,
+// a combining sequence, a Hangul syllable, a flag or a ZWJ emoji sequence.
+// Follows the UAX #29 rules with property tables covering the common scripts.
+void appendGraphemeBoundaries(std::string_view text, std::vector<uint32_t>& boundaries);
+
+#endif //GWAYTOOL_UTF8_H
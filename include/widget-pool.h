@@ -0,0 +1,88 @@
+#ifndef GWAYTOOL_WIDGET_POOL_H
+#define GWAYTOOL_WIDGET_POOL_H
+
+#include "geometry.h"
+#include "inplace-function.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stays valid until the widget is removed; a stale handle never aliases the
+// widget that later reuses its slot because the generation differs.
+struct WidgetHandle {
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+
+    bool operator==(const WidgetHandle& other) const = default;
+};
+
+enum WidgetFlags : uint8_t {
+    WidgetVisible = 1 << 0,
+    WidgetEnabled = 1 << 1,
+    WidgetHovered = 1 << 2,
+    WidgetPressed = 1 << 3,
+    // Painted by its owner instead of as a button.
+    WidgetSelfDrawn = 1 << 4,
+};
+
+// Byte range of a label inside the pool's label arena.
+struct LabelRun {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// Widgets stored as parallel dense arrays, so layout, hit testing and
+// painting walk contiguous memory. Removal swaps the last widget into the
+// hole; slots map the stable handles onto the moving dense indices.
+class WidgetPool {
+public:
+    using Callback = InplaceFunction<void()>;
+
+    void reserve(size_t count);
+
+    WidgetHandle add(const Rect& bounds, std::string_view label, Callback onClick,
+                     uint8_t flags = WidgetVisible | WidgetEnabled);
+    void remove(WidgetHandle handle);
+    bool isValid(WidgetHandle handle) const;
+
+    // Handle of the live widget in slot, the grid stores slots as ids.
+    WidgetHandle handleOf(uint32_t slot) const { return {slot, slots[slot].generation}; }
+
+    size_t size() const { return bounds.size(); }
+    size_t indexOf(WidgetHandle handle) const { return slots[handle.slot].index; }
+
+    // Dense arrays, index i is the same widget in each of them.
+    const std::vector<Rect>& getBounds() const { return bounds; }
+    const std::vector<uint8_t>& getFlags() const { return flags; }
+    const std::vector<LabelRun>& getLabels() const { return labels; }
+
+    std::string_view labelAt(size_t index) const;
+    void setBounds(WidgetHandle handle, const Rect& rect) { bounds[indexOf(handle)] = rect; }
+    void setFlag(WidgetHandle handle, uint8_t flag, bool on);
+    // Runs the callback unless the widget is disabled or has none.
+    void invoke(WidgetHandle handle);
+
+private:
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t index = 0;
+    };
+
+    std::vector<Rect> bounds;
+    std::vector<uint8_t> flags;
+    std::vector<LabelRun> labels;
+    std::vector<Callback> callbacks;
+    std::vector<uint32_t> slotOf; // dense index -> slot
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    std::string labelArena;
+    size_t deadLabelBytes = 0;
+
+    LabelRun storeLabel(std::string_view label);
+    void compactLabels();
+};
+
+#endif //GWAYTOOL_WIDGET_POOL_H
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <cstring>
@@ -5,7 +6,14 @@
 #include <xdg-shell-client-protocol.h>
 #include <linux/input-event-codes.h>
 #include "application.h"
+#include "log.h"
+#include "chart-kernels.h"
 #include <xkbcommon/xkbcommon.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <csignal>
+#include <sys/epoll.h>
+#include <cerrno>
 
 static int pointer_x = 0;
 static int pointer_y = 0;
@@ -23,53 +31,66 @@ const struct wl_registry_listener WaylandDisplay::registry_listener = {
     .global_remove = WaylandDisplay::registryRemoveHandler,
 };
 
+// Pointer events are collected here and handed to the application as one
+// PointerFrame on wl_pointer.frame. Seats older than version 5 have no frame
+// event, there every event is a frame of its own.
+static PointerFrame pendingPointer;
+static bool pointerHasFrames = false;
+
+static void pointerFrameHandler(void* data, struct wl_pointer* pointer) {
+    auto* app = static_cast<WaylandApplication*>(data);
+    PointerFrame frame = std::move(pendingPointer);
+    pendingPointer = PointerFrame{};
+    app->onPointerFrame(frame);
+}
+
+static void endPointerEvent(void* data, struct wl_pointer* pointer) {
+    if (!pointerHasFrames) {
+        pointerFrameHandler(data, pointer);
+    }
+}
+
 static void pointerEnterHandler(void* data, struct wl_pointer* pointer, uint32_t serial,
                                 struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y) {
-    pointer_x = wl_fixed_to_int(x);
-    pointer_y = wl_fixed_to_int(y);
-    std::cout << "Pointer entered surface at: (" << pointer_x << ", " << pointer_y << ")\n";
+    pendingPointer.entered = true;
+    pendingPointer.moved = true;
+    pendingPointer.x = wl_fixed_to_int(x);
+    pendingPointer.y = wl_fixed_to_int(y);
+    LOG_DEBUG("Pointer entered surface at: ({}, {})", pendingPointer.x, pendingPointer.y);
+    endPointerEvent(data, pointer);
 }
 
 static void pointerLeaveHandler(void* data, struct wl_pointer* pointer, uint32_t serial,
                                 struct wl_surface* surface) {
-    std::cout << "Pointer left the surface.\n";
+    pendingPointer.left = true;
+    LOG_DEBUG("Pointer left the surface.");
+    endPointerEvent(data, pointer);
 }
 
 static void pointerButtonHandler(void* data, struct wl_pointer* pointer, uint32_t serial,
                                  uint32_t time, uint32_t button, uint32_t state) {
-    const char* state_str = (state == WL_POINTER_BUTTON_STATE_PRESSED) ? "pressed" : "released";
-    auto* app = static_cast<WaylandApplication*>(data);
-
-    if (state_str == "pressed" && button == BTN_LEFT) {
-        app->onMouseClick(pointer_x, pointer_y);
-    }   else if (state == WL_POINTER_BUTTON_STATE_RELEASED) {
-            app->onMouseRelease(pointer_x, pointer_y);
-//    }
-}}
+    pendingPointer.buttons.push_back({button, state == WL_POINTER_BUTTON_STATE_PRESSED});
+    endPointerEvent(data, pointer);
+}
 
 
 static void pointerAxisHandler(void* data, struct wl_pointer* pointer, uint32_t time,
                                uint32_t axis, wl_fixed_t value) {
-    const char* axis_str = (axis == WL_POINTER_AXIS_VERTICAL_SCROLL) ? "vertical" : "horizontal";
-    std::cout << "Scroll " << axis_str << " by " << wl_fixed_to_double(value) << "\n";
+    if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL) {
+        pendingPointer.scrollY += wl_fixed_to_double(value);
+    } else {
+        pendingPointer.scrollX += wl_fixed_to_double(value);
+    }
+    endPointerEvent(data, pointer);
 }
 
 
 static void pointerMotionHandler(void* data, struct wl_pointer* pointer, uint32_t time,
                                  wl_fixed_t x, wl_fixed_t y) {
-    pointer_x = wl_fixed_to_int(x);
-    pointer_y = wl_fixed_to_int(y);
-
-    std::cout << "[DEBUG] Pointer moved to (" << pointer_x << ", " << pointer_y << ")\n";
-
-    WaylandApplication* app = static_cast<WaylandApplication*>(data);
-    app->onMouseMove(pointer_x, pointer_y);
-}
-
-
-static void pointerFrameHandler(void* data, struct wl_pointer* pointer) {
-//    std::cout << "Pointer frame event received.\n";
-    std::cout << std::endl;
+    pendingPointer.moved = true;
+    pendingPointer.x = wl_fixed_to_int(x);
+    pendingPointer.y = wl_fixed_to_int(y);
+    endPointerEvent(data, pointer);
 }
 
 
@@ -80,6 +101,12 @@ static const struct wl_pointer_listener pointer_listener = {
         .button = pointerButtonHandler,
         .axis = pointerAxisHandler,
         .frame = pointerFrameHandler,
+        .axis_source = [](void* data, struct wl_pointer* pointer, uint32_t source) {
+        },
+        .axis_stop = [](void* data, struct wl_pointer* pointer, uint32_t time, uint32_t axis) {
+        },
+        .axis_discrete = [](void* data, struct wl_pointer* pointer, uint32_t axis, int32_t discrete) {
+        },
 };
 
 WaylandDisplay::WaylandDisplay() {
@@ -87,7 +114,7 @@ WaylandDisplay::WaylandDisplay() {
     if (!display) {
         throw std::runtime_error("Failed to connect to Wayland display");
     }
-    std::cout << "Connected to Wayland display.\n";
+    LOG_INFO("Connected to Wayland display.");
 
     registry = wl_display_get_registry(display);
     wl_registry_add_listener(registry, &WaylandDisplay::registry_listener, this);
@@ -98,12 +125,13 @@ WaylandDisplay::WaylandDisplay() {
     if (!compositor || !xdg_wm_base) {
         throw std::runtime_error("Failed to initialize Wayland compositor or XDG shell");
     }
-    std::cout << "Wayland compositor and XDG shell initialized.\n";
+    LOG_INFO("Wayland compositor and XDG shell initialized.");
 }
 
 WaylandDisplay::~WaylandDisplay() {
+    clipboard.reset();
     wl_display_disconnect(display);
-    std::cout << "Disconnected from Wayland display.\n";
+    LOG_INFO("Disconnected from Wayland display.");
 }
 
 void WaylandDisplay::registryHandler(void* data, struct wl_registry* registry,
@@ -117,8 +145,12 @@ void WaylandDisplay::registryHandler(void* data, struct wl_registry* registry,
         self->xdg_wm_base = static_cast<struct xdg_wm_base*>(
                 wl_registry_bind(registry, id, &xdg_wm_base_interface, 1));
     } else if (strcmp(interface, "wl_seat") == 0) {
-        struct wl_seat* seat = static_cast<wl_seat*>(wl_registry_bind(registry, id, &wl_seat_interface, 1));
+        // Version 5 brings wl_pointer.frame, which the pointer handling batches on.
+        uint32_t seatVersion = std::min(version, 5u);
+        struct wl_seat* seat = static_cast<wl_seat*>(wl_registry_bind(registry, id, &wl_seat_interface, seatVersion));
+        pointerHasFrames = seatVersion >= 5;
         struct wl_pointer* pointer = wl_seat_get_pointer(seat);
+        self->clipboard.setSeat(seat);
 
         if (seat) {
             keyboard = wl_seat_get_keyboard(seat);
@@ -129,13 +161,16 @@ void WaylandDisplay::registryHandler(void* data, struct wl_registry* registry,
         } else {
             std::cerr << "Failed to get pointer for seat " << id << "\n";
         }
+    } else if (strcmp(interface, "wl_data_device_manager") == 0) {
+        self->clipboard.setManager(static_cast<wl_data_device_manager*>(
+                wl_registry_bind(registry, id, &wl_data_device_manager_interface, 3)));
     }
 
 }
 
 
 void WaylandDisplay::registryRemoveHandler(void* data, struct wl_registry* registry, uint32_t id) {
-    std::cout << "Global object removed: ID = " << id << "\n";
+    LOG_DEBUG("Global object removed: ID = {}", id);
 }
 
 void WaylandDisplay::roundtrip() {
@@ -159,7 +194,7 @@ void WaylandSurface::xdgSurfaceConfigureHandler(void* data, struct xdg_surface*
 
 void WaylandSurface::xdgToplevelConfigureHandler(void* data, struct xdg_toplevel* toplevel,
                                                  int32_t width, int32_t height, struct wl_array* states) {
-    std::cout << "Resize event: " << width << "x" << height << "\n";
+    LOG_DEBUG("Resize event: {}x{}", width, height);
 }
 
 WaylandSurface::WaylandSurface(WaylandDisplay& display) {
@@ -177,7 +212,7 @@ WaylandSurface::WaylandSurface(WaylandDisplay& display) {
     wl_surface_commit(surface);
     display.roundtrip();
 
-    std::cout << "Wayland surface and XDG shell setup complete.\n";
+    LOG_INFO("Wayland surface and XDG shell setup complete.");
 }
 
 WaylandSurface::~WaylandSurface() {
@@ -200,7 +235,7 @@ MyEGLContext::MyEGLContext(struct wl_display* display) {
 
 MyEGLContext::~MyEGLContext() {
     eglTerminate(egl_display);
-    std::cout << "EGL terminated.\n";
+    LOG_INFO("EGL terminated.");
 }
 
 void MyEGLContext::initialize(struct wl_display* display) {
@@ -227,13 +262,13 @@ void MyEGLContext::initialize(struct wl_display* display) {
     if (egl_display == EGL_NO_DISPLAY) {
         throw std::runtime_error("Failed to get EGL display");
     }
-    std::cout << "Created EGL display.\n";
+    LOG_INFO("Created EGL display.");
 
     // Initialize EGL
     if (eglInitialize(egl_display, &major, &minor) != EGL_TRUE) {
         throw std::runtime_error("Failed to initialize EGL");
     }
-    std::cout << "EGL initialized: version " << major << "." << minor << "\n";
+    LOG_INFO("EGL initialized: version {}.{}", major, minor);
 
     // Bind the EGL API
     if (!eglBindAPI(EGL_OPENGL_API)) {
@@ -242,7 +277,7 @@ void MyEGLContext::initialize(struct wl_display* display) {
 
     // Get the EGL configurations
     eglGetConfigs(egl_display, NULL, 0, &count);
-    std::cout << "EGL has " << count << " configurations.\n";
+    LOG_DEBUG("EGL has {} configurations.", count);
 
     configs = static_cast<EGLConfig*>(calloc(count, sizeof(EGLConfig)));
     if (!configs) {
@@ -253,10 +288,10 @@ void MyEGLContext::initialize(struct wl_display* display) {
 
     for (int i = 0; i < n; i++) {
         eglGetConfigAttrib(egl_display, configs[i], EGL_BUFFER_SIZE, &size);
-        std::cout << "Buffer size for config " << i << " is " << size << "\n";
+        LOG_DEBUG("Buffer size for config {} is {}", i, size);
 
         eglGetConfigAttrib(egl_display, configs[i], EGL_RED_SIZE, &size);
-        std::cout << "Red size for config " << i << " is " << size << "\n";
+        LOG_DEBUG("Red size for config {} is {}", i, size);
 
         // Use the first configuration
         egl_conf = configs[i];
@@ -270,7 +305,7 @@ void MyEGLContext::initialize(struct wl_display* display) {
     if (egl_context == EGL_NO_CONTEXT) {
         throw std::runtime_error("Failed to create EGL context");
     }
-    std::cout << "EGL context created successfully.\n";
+    LOG_INFO("EGL context created successfully.");
 }
 
 EGLSurface MyEGLContext::createWindowSurface(struct wl_egl_window* egl_window) {
@@ -278,7 +313,7 @@ EGLSurface MyEGLContext::createWindowSurface(struct wl_egl_window* egl_window) {
     if (surface == EGL_NO_SURFACE) {
         throw std::runtime_error("Failed to create EGL window surface");
     }
-    std::cout << "EGL window surface - Created" <<  "\n";
+    LOG_INFO("EGL window surface - Created");
     return surface;
 }
 
@@ -297,16 +332,55 @@ CairoRenderer::CairoRenderer(MyEGLContext& egl, EGLSurface egl_surface) {
     if (!cairo_surface) {
         throw std::runtime_error("Failed to create Cairo surface");
     }
+    LOG_INFO("Chart kernels: {}", chartKernelIsa());
+}
+
+void CairoRenderer::present() {
+    if (batchDepth > 0) {
+        swapDeferred = true;
+        return;
+    }
+    swapBuffers();
+}
+
+void CairoRenderer::endBatch() {
+    if (--batchDepth == 0 && swapDeferred) {
+        swapDeferred = false;
+        swapBuffers();
+    }
+}
+
+void CairoRenderer::swapBuffers() {
+    if (hoverTargetsChanged) {
+        // The charts under the pointer changed since it last moved.
+        hoverTargetsChanged = false;
+        hovered = pointNear(hoverX, hoverY);
+    }
+    // The tooltip is only in the window while the frame is swapped to the
+    // screen, so nothing drawn between swaps ends up under it.
+    cairo_t* cr = cairo_create(cairo_surface);
+    showTooltip(cr);
+    cairo_gl_surface_swapbuffers(cairo_surface);
+    hideTooltip(cr);
+    cairo_destroy(cr);
 }
 
 CairoRenderer::~CairoRenderer() {
+    chartLayers.clear();
+    if (chartImage) {
+        cairo_surface_destroy(chartImage);
+    }
+    if (tooltipUnder) {
+        cairo_surface_destroy(tooltipUnder);
+    }
     cairo_surface_destroy(cairo_surface);
     cairo_device_destroy(cairo_device);
-    std::cout << "Cairo resources released.\n";
+    LOG_INFO("Cairo resources released.");
 }
 
 void CairoRenderer::clearArea(int x, int y, int width, int height) {
     cairo_t* cr = cairo_create(cairo_surface);
+    forgetHoverTargets({x, y, width, height});
 
     cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
 
@@ -314,7 +388,7 @@ void CairoRenderer::clearArea(int x, int y, int width, int height) {
     cairo_fill(cr);
 
     cairo_destroy(cr);
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
 }
 
 
@@ -335,7 +409,7 @@ void CairoRenderer::drawText(const std::string& text, int x, int y, double r, do
 //    cairo_rectangle(cr, x - 10, y - 30, 150, 30);
 //    cairo_stroke(cr);
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
     cairo_destroy(cr);
 }
 
@@ -358,28 +432,75 @@ void CairoRenderer::drawImage(const std::string& imagePath, int x, int y, double
 
     cairo_restore(cr);
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
     cairo_destroy(cr);
     cairo_surface_destroy(image_surface);
 }
 
+WidgetHandle CairoRenderer::addButton(Button button) {
+    Rect bounds{button.x, button.y, button.width, button.height};
+    WidgetHandle handle = widgets.add(bounds, button.label, std::move(button.onClick));
+    hitGrid.insert(handle.slot, bounds);
+    return handle;
+}
+
+void CairoRenderer::removeWidget(WidgetHandle handle) {
+    if (!widgets.isValid(handle)) return;
+    hitGrid.remove(handle.slot);
+    widgets.remove(handle);
+    if (textInputWidget == handle) {
+        textInputWidget.reset();
+    }
+}
+
+std::optional<WidgetHandle> CairoRenderer::widgetAt(int x, int y) const {
+    std::optional<WidgetId> slot = hitGrid.hitTest(x, y);
+    if (!slot) return std::nullopt;
+    return widgets.handleOf(*slot);
+}
+
 void CairoRenderer::handleClick(int x, int y) {
-    for (const Button& button : buttons) {
-        if (button.contains(x, y)) {
-            if (button.onClick) {
-                button.onClick();
-            }
-            break;
-        }
+    if (std::optional<WidgetHandle> handle = widgetAt(x, y)) {
+        clickWidget(*handle);
+    }
+}
+
+void CairoRenderer::clickWidget(WidgetHandle handle) {
+    widgets.invoke(handle);
+}
+
+void CairoRenderer::trackTextInput(const TextInput& textInput) {
+    Rect bounds{textInput.x, textInput.y, textInput.width, textInput.height};
+    if (!textInputWidget) {
+        textInputWidget = widgets.add(bounds, {}, {}, WidgetVisible | WidgetEnabled | WidgetSelfDrawn);
+        hitGrid.insert(textInputWidget->slot, bounds, 1);
+    } else if (hitGrid.getBounds(textInputWidget->slot) != bounds) {
+        widgets.setBounds(*textInputWidget, bounds);
+        hitGrid.move(textInputWidget->slot, bounds);
     }
 }
 
 void CairoRenderer::drawButton() {
     cairo_t* cr = cairo_create(cairo_surface);
-    for (const Button& button : buttons) {
-        button.draw(cr);
+    const std::vector<Rect>& bounds = widgets.getBounds();
+    const std::vector<uint8_t>& flags = widgets.getFlags();
+
+    cairo_set_source_rgb(cr, 1.0, 1.0, 0.0);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if ((flags[i] & (WidgetVisible | WidgetSelfDrawn)) != WidgetVisible) continue;
+        cairo_rectangle(cr, bounds[i].x, bounds[i].y, bounds[i].width, bounds[i].height);
     }
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    cairo_fill(cr);
+
+    std::string label;
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if ((flags[i] & (WidgetVisible | WidgetSelfDrawn)) != WidgetVisible) continue;
+        label.assign(widgets.labelAt(i));
+        cairo_move_to(cr, bounds[i].x + 10, bounds[i].y + bounds[i].height / 2);
+        cairo_show_text(cr, label.c_str());
+    }
+    present();
     cairo_destroy(cr);
 }
 
@@ -388,9 +509,30 @@ void CairoRenderer::drawButton() {
 // -------------------- WaylandApplication Implementation --------------------
 void CairoRenderer::drawTextInput(const TextInput& textInput) {
     textInputAdded = true;
+    trackTextInput(textInput);
     cairo_t* cr = cairo_create(cairo_surface);
     textInput.draw(cr);
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
+    cairo_destroy(cr);
+}
+
+void CairoRenderer::drawTextInputRegion(const TextInput& textInput, const Rect& area) {
+    cairo_t* cr = cairo_create(cairo_surface);
+    cairo_rectangle(cr, area.x, area.y, area.width, area.height);
+    cairo_clip(cr);
+    textInput.draw(cr);
+    present();
+    cairo_destroy(cr);
+}
+
+void CairoRenderer::drawMovedTextInput(const TextInput& textInput, const Rect& previous) {
+    trackTextInput(textInput);
+    cairo_t* cr = cairo_create(cairo_surface);
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+    cairo_rectangle(cr, previous.x, previous.y, previous.width, previous.height);
+    cairo_fill(cr);
+    textInput.draw(cr);
+    present();
     cairo_destroy(cr);
 }
 
@@ -402,19 +544,20 @@ WaylandApplication::WaylandApplication()
     if (!egl_window) {
         throw std::runtime_error("Failed to create Wayland EGL window");
     }
-    std::cout << "WaylandApplication initialized successfully.\n";
+    // Leave through the loop so the destructors still flush the text.
+    loop.addSignal(SIGINT, [this](int) { loop.quit(); });
+    loop.addSignal(SIGTERM, [this](int) { loop.quit(); });
+    LOG_INFO("WaylandApplication initialized successfully.");
 }
 
 const struct wl_keyboard_listener WaylandApplication::keyboard_listener = {
-        .keymap = [](void* data, struct wl_keyboard* keyboard, uint32_t format, int fd, uint32_t size) {
-        },
+        .keymap = WaylandApplication::keyboardKeymapHandler,
         .enter = [](void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface, struct wl_array* keys) {
         },
         .leave = [](void* data, struct wl_keyboard* keyboard, uint32_t serial, struct wl_surface* surface) {
         },
         .key = WaylandApplication::keyboardKeyHandler,
-        .modifiers = [](void* data, struct wl_keyboard* keyboard, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group) {
-        },
+        .modifiers = WaylandApplication::keyboardModifiersHandler,
         .repeat_info = [](void* data, struct wl_keyboard* keyboard, int32_t rate, int32_t delay) {
         }
 };
@@ -435,112 +578,282 @@ int TextInput::getY() const {
     return y;
 }
 
+void WaylandApplication::onPointerFrame(const PointerFrame& frame) {
+    if (frame.entered) {
+        pointerInside = true;
+    }
+    if (frame.left && !frame.entered) {
+        // Motion still waiting for a frame callback is stale now, and the
+        // tooltip goes whatever else this frame carries.
+        pointerInside = false;
+        motionDeferred = false;
+        hoverCharts(-1, -1);
+    }
+    if (frame.moved) {
+        pointer_x = frame.x;
+        pointer_y = frame.y;
+        if (!motionDeferred) {
+            motionDeferred = true;
+            if (loop.isFramePending()) {
+                // The previous redraw is not on screen yet, catch up with
+                // the latest position once it is.
+                loop.requestFrame(surface.getSurface(), [this] { flushMotion(); });
+            }
+        }
+    }
+    if (!frame.buttons.empty() || !loop.isFramePending()) {
+        flushMotion();
+    }
+
+    for (const PointerFrame::Button& button : frame.buttons) {
+        if (button.pressed && button.button == BTN_LEFT) {
+            onMouseClick(pointer_x, pointer_y);
+        } else if (!button.pressed) {
+            onMouseRelease(pointer_x, pointer_y);
+        }
+    }
+
+    if (frame.scrollY != 0) {
+        LOG_DEBUG("Scroll vertical by {}", frame.scrollY);
+    }
+    if (frame.scrollX != 0) {
+        LOG_DEBUG("Scroll horizontal by {}", frame.scrollX);
+    }
+}
+
+void WaylandApplication::flushMotion() {
+    if (!motionDeferred) return;
+    motionDeferred = false;
+    onMouseMove(pointer_x, pointer_y);
+}
+
 void WaylandApplication::onMouseRelease(int x, int y) {
     isDragging = false;
 }
 
 void WaylandApplication::onMouseMove(int x, int y) {
     if (isDragging) {
-        std::cout << "Dragging started. Mouse position: (" << x << ", " << y << ")\n";
+        LOG_DEBUG("Dragging started. Mouse position: ({}, {})", x, y);
 
         int oldX = textInput.getX();
         int oldY = textInput.getY();
-        std::cout << "Old position: (" << oldX << ", " << oldY << ")\n";
+        LOG_DEBUG("Old position: ({}, {})", oldX, oldY);
 
         textInput.setX(x - dragOffsetX);
         textInput.setY(y - dragOffsetY);
 
-        std::cout << "Clearing area: (" << oldX << ", " << oldY << ")\n";
-//        renderer.clearArea(oldX, oldY, textInput.width, textInput.height);
-        renderer.clearArea(oldX - 4, oldY - 4, textInput.width + 8, textInput.height + 8);
+        LOG_DEBUG("Drawing new position: ({}, {})", textInput.getX(), textInput.getY());
+        loop.requestFrame(surface.getSurface());
+        renderer.drawMovedTextInput(textInput, {oldX - 4, oldY - 4, textInput.width + 8, textInput.height + 8});
+    } else {
+        hoverCharts(x, y);
+    }
+}
 
+void WaylandApplication::hoverCharts(int x, int y) {
+    // Positions reported before the pointer left hover nothing.
+    if (!pointerInside) {
+        x = -1;
+        y = -1;
+    }
+    if (renderer.updateHover(x, y)) {
+        loop.requestFrame(surface.getSurface());
+        renderer.drawTooltip();
+    }
+}
 
-        std::cout << "Drawing new position: (" << textInput.getX() << ", " << textInput.getY() << ")\n";
+void WaylandApplication::redrawTextInput(const Rect& caretBefore, uint64_t revisionBefore, bool focusBefore) {
+    if (textInput.getRevision() != revisionBefore || textInput.isFocused != focusBefore) {
+        loop.requestFrame(surface.getSurface());
         renderer.drawTextInput(textInput);
+        return;
+    }
+    Rect caretAfter = textInput.getCaretBounds();
+    if (caretAfter != caretBefore) {
+        loop.requestFrame(surface.getSurface());
+        renderer.drawTextInputRegion(textInput, caretBefore.united(caretAfter));
     }
 }
 
 void WaylandApplication::onMouseClick(int x, int y) {
+    std::optional<WidgetHandle> hit = renderer.widgetAt(x, y);
+    bool onTextInput = hit && renderer.isTextInput(*hit);
+
     if (textInputAdded) {
-        if (textInput.contains(x, y)) {
-            textInput.isFocused = true;
-            std::cout << "TextInput focused.\n";
+        Rect caretBefore = textInput.getCaretBounds();
+        uint64_t revisionBefore = textInput.getRevision();
+        bool focusBefore = textInput.isFocused;
+
+        if (onTextInput) {
+            textInput.setFocused(true);
+            textInput.handleClick(x, y, currentModifiers().shift);
+            LOG_DEBUG("TextInput focused.");
 
             if (!isDragging) {
                 isDragging = true;
-                std::cout << "Dragging initialized.\n";
+                LOG_DEBUG("Dragging initialized.");
                 dragOffsetX = x - textInput.getX();
                 dragOffsetY = y - textInput.getY();
             }
         } else {
-            textInput.isFocused = false;
+            textInput.setFocused(false);
         }
-        renderer.drawTextInput(textInput);
+        redrawTextInput(caretBefore, revisionBefore, focusBefore);
     }
-    if(buttonAdded) {
-        renderer.handleClick(x, y);
+    if (buttonAdded && hit && !onTextInput) {
+        renderer.clickWidget(*hit);
     }
 }
 
 
+void WaylandApplication::keyboardKeymapHandler(void* data, struct wl_keyboard* keyboard,
+                                               uint32_t format, int32_t fd, uint32_t size) {
+    auto* app = static_cast<WaylandApplication*>(data);
+
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+        close(fd);
+        return;
+    }
+
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "Failed to map XKB keymap." << std::endl;
+        close(fd);
+        return;
+    }
+
+    struct xkb_keymap* keymap = xkb_keymap_new_from_string(app->xkbContext, static_cast<const char*>(map),
+                                                           XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    munmap(map, size);
+    close(fd);
+    if (!keymap) {
+        std::cerr << "Failed to create XKB keymap." << std::endl;
+        return;
+    }
+
+    struct xkb_state* state = xkb_state_new(keymap);
+    if (!state) {
+        std::cerr << "Failed to create XKB state." << std::endl;
+        xkb_keymap_unref(keymap);
+        return;
+    }
+
+    xkb_state_unref(app->xkbState);
+    xkb_keymap_unref(app->xkbKeymap);
+    app->xkbKeymap = keymap;
+    app->xkbState = state;
+}
+
+void WaylandApplication::keyboardModifiersHandler(void* data, struct wl_keyboard* keyboard,
+                                                  uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched,
+                                                  uint32_t mods_locked, uint32_t group) {
+    auto* app = static_cast<WaylandApplication*>(data);
+    if (app->xkbState) {
+        xkb_state_update_mask(app->xkbState, mods_depressed, mods_latched, mods_locked, 0, 0, group);
+    }
+}
+
+KeyModifiers WaylandApplication::currentModifiers() const {
+    KeyModifiers modifiers;
+    if (xkbState) {
+        modifiers.shift = xkb_state_mod_name_is_active(xkbState, XKB_MOD_NAME_SHIFT, XKB_STATE_MODS_EFFECTIVE) > 0;
+        modifiers.ctrl = xkb_state_mod_name_is_active(xkbState, XKB_MOD_NAME_CTRL, XKB_STATE_MODS_EFFECTIVE) > 0;
+    }
+    return modifiers;
+}
+
 void WaylandApplication::keyboardKeyHandler(void* data, struct wl_keyboard* keyboard,
                                             uint32_t serial, uint32_t time, uint32_t key,
                                             uint32_t state) {
     auto* app = static_cast<WaylandApplication*>(data);
 
-    std::cout << "Keyboard event: key=" << key
-              << ", state=" << (state == WL_KEYBOARD_KEY_STATE_PRESSED ? "PRESSED" : "RELEASED")
-              << ", time=" << time << std::endl;
+    LOG_DEBUG("Keyboard event: key={}, state={}, time={}",
+              key, state == WL_KEYBOARD_KEY_STATE_PRESSED ? "PRESSED" : "RELEASED", time);
 
     if (state == WL_KEYBOARD_KEY_STATE_PRESSED) {
-        struct xkb_context* ctx = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-        if (!ctx) {
-            std::cerr << "Failed to create XKB context." << std::endl;
-            return;
-        }
-
-        struct xkb_keymap* keymap = xkb_keymap_new_from_names(ctx, nullptr, XKB_KEYMAP_COMPILE_NO_FLAGS);
-        if (!keymap) {
-            std::cerr << "Failed to create XKB keymap." << std::endl;
-            xkb_context_unref(ctx);
-            return;
-        }
-
-        struct xkb_state* xkb_state = xkb_state_new(keymap);
-        if (!xkb_state) {
-            std::cerr << "Failed to create XKB state." << std::endl;
-            xkb_keymap_unref(keymap);
-            xkb_context_unref(ctx);
-            return;
+        if (!app->xkbState) {
+            // No keymap from the compositor yet, fall back to the default one.
+            app->xkbKeymap = xkb_keymap_new_from_names(app->xkbContext, nullptr, XKB_KEYMAP_COMPILE_NO_FLAGS);
+            if (!app->xkbKeymap) {
+                std::cerr << "Failed to create XKB keymap." << std::endl;
+                return;
+            }
+            app->xkbState = xkb_state_new(app->xkbKeymap);
+            if (!app->xkbState) {
+                std::cerr << "Failed to create XKB state." << std::endl;
+                return;
+            }
         }
 
-        uint32_t keysym = xkb_state_key_get_one_sym(xkb_state, key + 8); // Додаємо 8 для коректного keycode
+        uint32_t keysym = xkb_state_key_get_one_sym(app->xkbState, key + 8); // Додаємо 8 для коректного keycode
         char buffer[64];
         int size = xkb_keysym_to_utf8(keysym, buffer, sizeof(buffer));
         buffer[size] = '\0';
 
-        std::cout << "Key pressed: keysym=" << keysym
-                  << ", utf8='" << buffer << "'"
-                  << ", keycode=" << key << std::endl;
-//        app->textInput.isFocused = true;
+        LOG_DEBUG("Key pressed: keysym={}, utf8='{}', keycode={}", keysym, buffer, key);
         if (app->textInput.isFocused) {
-            if (keysym == XKB_KEY_Escape) {
-                std::cout << "Escape key detected. Unfocusing text input." << std::endl;
-                app->textInput.isFocused = false;
+            Rect caretBefore = app->textInput.getCaretBounds();
+            uint64_t revisionBefore = app->textInput.getRevision();
+            KeyModifiers modifiers = app->currentModifiers();
+
+            if ((modifiers.ctrl && (keysym == XKB_KEY_v || keysym == XKB_KEY_V)) ||
+                (modifiers.shift && keysym == XKB_KEY_Insert)) {
+                app->startPaste();
+            } else if (keysym == XKB_KEY_Escape) {
+                LOG_DEBUG("Escape key detected. Unfocusing text input.");
+                app->textInput.setFocused(false);
             } else {
-                app->textInput.handleKeyPress(keysym);
-                app->renderer.drawTextInput(app->textInput);
+                app->textInput.handleKeyPress(keysym, modifiers);
             }
+            app->redrawTextInput(caretBefore, revisionBefore, true);
         }
+    }
+}
 
-        xkb_state_unref(xkb_state);
-        xkb_keymap_unref(keymap);
-        xkb_context_unref(ctx);
+void WaylandApplication::startPaste() {
+    if (pasteFd >= 0) return;
+
+    pasteFd = display.getClipboard().receiveText();
+    if (pasteFd < 0) return;
+    wl_display_flush(display.getDisplay());
+    textInput.beginBulkInsert();
+    loop.addFd(pasteFd, EPOLLIN, [this](uint32_t) { readPaste(); });
+}
+
+void WaylandApplication::readPaste() {
+    // Bounded per wakeup so a huge paste does not starve the Wayland fd.
+    char buffer[1 << 16];
+    for (int chunk = 0; chunk < 16; ++chunk) {
+        ssize_t n = read(pasteFd, buffer, sizeof(buffer));
+        if (n > 0) {
+            textInput.appendBulk(std::string_view(buffer, static_cast<size_t>(n)));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+
+        if (n < 0) {
+            std::cerr << "Paste failed: " << strerror(errno) << "\n";
+        }
+        loop.removeFd(pasteFd);
+        close(pasteFd);
+        pasteFd = -1;
+        textInput.endBulkInsert();
+        loop.requestFrame(surface.getSurface());
+        renderer.drawTextInput(textInput);
+        return;
     }
 }
 
 WaylandApplication::~WaylandApplication() {
+    if (pasteFd >= 0) {
+        loop.removeFd(pasteFd);
+        close(pasteFd);
+    }
+    xkb_state_unref(xkbState);
+    xkb_keymap_unref(xkbKeymap);
+    xkb_context_unref(xkbContext);
     wl_egl_window_destroy(egl_window);
-    std::cout << "WaylandApplication resources cleaned up.\n";
+    LOG_INFO("WaylandApplication resources cleaned up.");
 }
 
@@ -0,0 +1,263 @@
+#include "aggregation.h"
+#include "chart-kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Rows a chunk is worth splitting off for, and rows mapped per kernel call.
+constexpr size_t rowGrain = 1 << 16;
+constexpr size_t block = 1024;
+// Resolution quantile edges are placed at.
+constexpr size_t quantileResolution = 1 << 16;
+
+// Calls body(partial, begin, end) for at most one chunk of [0, count) per
+// pool thread, each with its own copy of initial, and returns the partials.
+template<typename Partial, typename Body>
+std::vector<Partial> partialsOver(ThreadPool& pool, size_t count, const Partial& initial, Body&& body) {
+    size_t chunks = std::clamp<size_t>((count + rowGrain - 1) / rowGrain, 1, pool.concurrency());
+    std::vector<Partial> partials(chunks, initial);
+    pool.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            body(partials[chunk], count * chunk / chunks, count * (chunk + 1) / chunks);
+        }
+    });
+    return partials;
+}
+
+template<ChartValue T>
+bool isValue(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return !std::isnan(value);
+    } else {
+        return true;
+    }
+}
+
+template<ChartValue T>
+Summary summarizeRange(std::span<const T> values) {
+    Summary summary;
+    if (values.empty()) return summary;
+    double sum = sumOf(values);
+    if constexpr (std::is_floating_point_v<T>) {
+        // A NaN anywhere makes the sum NaN; the kernels would take it for a value.
+        if (std::isnan(sum)) {
+            for (T value : values) {
+                if (std::isnan(value)) continue;
+                double number = static_cast<double>(value);
+                summary.merge(Summary{1, number, number, number});
+            }
+            return summary;
+        }
+    }
+    auto [low, high] = minMaxOf(values);
+    return Summary{values.size(), sum, static_cast<double>(low), static_cast<double>(high)};
+}
+
+// Counts values into bins equal width bins over [low, high].
+template<ChartValue T>
+std::vector<int64_t> countBins(std::span<const T> values, size_t bins, double low, double high, ThreadPool& pool) {
+    double scale = high > low ? static_cast<double>(bins) / (high - low) : 0.0;
+    double offset = -low * scale;
+    auto partials = partialsOver(pool, values.size(), std::vector<int64_t>(bins, 0),
+                                 [&](std::vector<int64_t>& counts, size_t first, size_t last) {
+        float positions[block];
+        for (size_t at = first; at < last; at += block) {
+            size_t n = std::min(block, last - at);
+            affineTransform(values.subspan(at, n), scale, offset, std::span<float>(positions, n));
+            for (size_t i = 0; i < n; ++i) {
+                float position = positions[i];
+                // NaN fails the test; the top value lands in the last bin.
+                if (!(position >= 0.0f)) continue;
+                counts[std::min(static_cast<size_t>(position), bins - 1)]++;
+            }
+        }
+    });
+
+    std::vector<int64_t> counts(bins, 0);
+    for (const auto& partial : partials) {
+        for (size_t bin = 0; bin < bins; ++bin) {
+            counts[bin] += partial[bin];
+        }
+    }
+    return counts;
+}
+
+std::string formatEdge(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+}
+
+void Summary::merge(const Summary& other) {
+    count += other.count;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+template<ChartValue T>
+Summary summarize(std::span<const T> values, ThreadPool& pool) {
+    auto partials = partialsOver(pool, values.size(), Summary{}, [&](Summary& summary, size_t first, size_t last) {
+        summary = summarizeRange(values.subspan(first, last - first));
+    });
+    Summary summary;
+    for (const Summary& partial : partials) {
+        summary.merge(partial);
+    }
+    return summary;
+}
+
+template<ChartValue T>
+std::vector<Summary> groupBy(std::span<const int32_t> codes, size_t groups, std::span<const T> values,
+                             ThreadPool& pool) {
+    size_t count = std::min(codes.size(), values.size());
+    auto partials = partialsOver(pool, count, std::vector<Summary>(groups),
+                                 [&](std::vector<Summary>& summaries, size_t first, size_t last) {
+        for (size_t row = first; row < last; ++row) {
+            auto group = static_cast<size_t>(static_cast<uint32_t>(codes[row]));
+            T value = values[row];
+            if (group >= groups || !isValue(value)) continue;
+            Summary& summary = summaries[group];
+            double number = static_cast<double>(value);
+            summary.count++;
+            summary.sum += number;
+            summary.min = std::min(summary.min, number);
+            summary.max = std::max(summary.max, number);
+        }
+    });
+
+    std::vector<Summary> summaries(groups);
+    for (const auto& partial : partials) {
+        for (size_t group = 0; group < groups; ++group) {
+            summaries[group].merge(partial[group]);
+        }
+    }
+    return summaries;
+}
+
+std::vector<int64_t> countBy(std::span<const int32_t> codes, size_t groups, ThreadPool& pool) {
+    auto partials = partialsOver(pool, codes.size(), std::vector<int64_t>(groups, 0),
+                                 [&](std::vector<int64_t>& counts, size_t first, size_t last) {
+        for (size_t row = first; row < last; ++row) {
+            auto group = static_cast<size_t>(static_cast<uint32_t>(codes[row]));
+            if (group < groups) counts[group]++;
+        }
+    });
+
+    std::vector<int64_t> counts(groups, 0);
+    for (const auto& partial : partials) {
+        for (size_t group = 0; group < groups; ++group) {
+            counts[group] += partial[group];
+        }
+    }
+    return counts;
+}
+
+std::vector<std::string> Histogram::labels() const {
+    std::vector<std::string> labels;
+    for (size_t bin = 0; bin + 1 < edges.size(); ++bin) {
+        labels.push_back(formatEdge(edges[bin]) + "-" + formatEdge(edges[bin + 1]));
+    }
+    return labels;
+}
+
+template<ChartValue T>
+Histogram histogram(std::span<const T> values, size_t bins, ThreadPool& pool) {
+    bins = std::max<size_t>(bins, 1);
+    Summary summary = summarize(values, pool);
+    if (summary.count == 0) return Histogram{};
+
+    Histogram result;
+    for (size_t edge = 0; edge <= bins; ++edge) {
+        result.edges.push_back(summary.min + (summary.max - summary.min) * static_cast<double>(edge) / bins);
+    }
+    result.counts = countBins(values, bins, summary.min, summary.max, pool);
+    return result;
+}
+
+template<ChartValue T>
+Histogram quantileHistogram(std::span<const T> values, size_t bins, ThreadPool& pool) {
+    bins = std::max<size_t>(bins, 1);
+    Summary summary = summarize(values, pool);
+    if (summary.count == 0) return Histogram{};
+
+    // Each bin closes on the first fine edge reaching the next share of the
+    // values. A fine bin reaching several shares closes one bin and skips
+    // the rest, and no bin closes empty or leaves the last one empty.
+    std::vector<int64_t> fine = countBins(values, quantileResolution, summary.min, summary.max, pool);
+    double fine_width = (summary.max - summary.min) / quantileResolution;
+    auto total = static_cast<int64_t>(summary.count);
+    auto reached = [&](int64_t seen, size_t share) {
+        return static_cast<double>(seen) >= static_cast<double>(total) * static_cast<double>(share) / bins;
+    };
+    Histogram result;
+    result.edges.push_back(summary.min);
+    int64_t seen = 0;
+    int64_t in_bin = 0;
+    size_t share = 1;
+    for (size_t position = 0; position + 1 < fine.size() && share < bins; ++position) {
+        seen += fine[position];
+        in_bin += fine[position];
+        if (in_bin > 0 && seen < total && reached(seen, share)) {
+            result.edges.push_back(summary.min + fine_width * static_cast<double>(position + 1));
+            result.counts.push_back(in_bin);
+            in_bin = 0;
+            while (share < bins && reached(seen, share)) ++share;
+        }
+    }
+    in_bin += total - seen;
+    result.edges.push_back(summary.max);
+    result.counts.push_back(in_bin);
+    return result;
+}
+
+GroupedValues aggregateBy(const TableModel& table, size_t groupColumn, size_t valueColumn, Aggregation aggregation,
+                          size_t firstRow, ThreadPool& pool) {
+    TableModel::Categories groups = table.categories(groupColumn, firstRow);
+    size_t count = groups.names.size();
+
+    std::vector<double> values(count);
+    if (aggregation == Aggregation::Count) {
+        std::vector<int64_t> counts = countBy(groups.codes.values(), count, pool);
+        std::copy(counts.begin(), counts.end(), values.begin());
+    } else {
+        Dataset<double> column = table.column<double>(valueColumn, firstRow);
+        std::vector<Summary> summaries = groupBy(groups.codes.values(), count, column.values(), pool);
+        for (size_t group = 0; group < count; ++group) {
+            const Summary& summary = summaries[group];
+            switch (aggregation) {
+                case Aggregation::Sum:
+                    values[group] = summary.sum;
+                    break;
+                case Aggregation::Min:
+                    values[group] = summary.count > 0 ? summary.min : 0.0;
+                    break;
+                case Aggregation::Max:
+                    values[group] = summary.count > 0 ? summary.max : 0.0;
+                    break;
+                case Aggregation::Mean:
+                default:
+                    values[group] = summary.mean();
+                    break;
+            }
+        }
+    }
+    return GroupedValues{std::move(groups.names), Dataset<double>(std::move(values))};
+}
+
+#define GWAYTOOL_AGGREGATION(T) \
+    template Summary summarize<T>(std::span<const T>, ThreadPool&); \
+    template std::vector<Summary> groupBy<T>(std::span<const int32_t>, size_t, std::span<const T>, ThreadPool&); \
+    template Histogram histogram<T>(std::span<const T>, size_t, ThreadPool&); \
+    template Histogram quantileHistogram<T>(std::span<const T>, size_t, ThreadPool&);
+
+GWAYTOOL_AGGREGATION(int32_t)
+GWAYTOOL_AGGREGATION(int64_t)
+GWAYTOOL_AGGREGATION(float)
+GWAYTOOL_AGGREGATION(double)
+
+#undef GWAYTOOL_AGGREGATION
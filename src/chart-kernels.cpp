@@ -0,0 +1,391 @@
+#include "chart-kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GWAYTOOL_KERNELS_AVX2 1
+#define GWAYTOOL_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GWAYTOOL_KERNELS_NEON 1
+#endif
+
+namespace {
+
+template<ChartValue T>
+struct Kernels {
+    void (*minMax)(const T* values, size_t count, T& low, T& high);
+    double (*sum)(const T* values, size_t count);
+    void (*transform)(const T* values, size_t count, double scale, double offset, float* out);
+};
+
+template<ChartValue T>
+void minMaxScalar(const T* values, size_t count, T& low, T& high) {
+    low = high = values[0];
+    for (size_t i = 1; i < count; ++i) {
+        low = std::min(low, values[i]);
+        high = std::max(high, values[i]);
+    }
+}
+
+template<ChartValue T>
+double sumScalar(const T* values, size_t count) {
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        total += static_cast<double>(values[i]);
+    }
+    return total;
+}
+
+template<ChartValue T>
+void transformScalar(const T* values, size_t count, double scale, double offset, float* out) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(offset + scale * static_cast<double>(values[i]));
+    }
+}
+
+#ifdef GWAYTOOL_KERNELS_AVX2
+
+// Per type AVX2 operations. min and max are std::min and std::max lane by
+// lane, so a NaN in b leaves a as it is. widen loads four values as doubles;
+// int64 has no AVX2 conversion and keeps the scalar sum and transform.
+struct Avx2Float {
+    using Value = float;
+    using Vector = __m256;
+    static constexpr size_t lanes = 8;
+    static constexpr bool widens = true;
+    GWAYTOOL_AVX2 static Vector load(const float* p) { return _mm256_loadu_ps(p); }
+    GWAYTOOL_AVX2 static void store(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+    GWAYTOOL_AVX2 static Vector fill(float value) { return _mm256_set1_ps(value); }
+    // minps and maxps return their second operand when either is NaN.
+    GWAYTOOL_AVX2 static Vector min(Vector a, Vector b) { return _mm256_min_ps(b, a); }
+    GWAYTOOL_AVX2 static Vector max(Vector a, Vector b) { return _mm256_max_ps(b, a); }
+    GWAYTOOL_AVX2 static __m256d widen(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+};
+
+struct Avx2Double {
+    using Value = double;
+    using Vector = __m256d;
+    static constexpr size_t lanes = 4;
+    static constexpr bool widens = true;
+    GWAYTOOL_AVX2 static Vector load(const double* p) { return _mm256_loadu_pd(p); }
+    GWAYTOOL_AVX2 static void store(double* p, Vector v) { _mm256_storeu_pd(p, v); }
+    GWAYTOOL_AVX2 static Vector fill(double value) { return _mm256_set1_pd(value); }
+    GWAYTOOL_AVX2 static Vector min(Vector a, Vector b) { return _mm256_min_pd(b, a); }
+    GWAYTOOL_AVX2 static Vector max(Vector a, Vector b) { return _mm256_max_pd(b, a); }
+    GWAYTOOL_AVX2 static __m256d widen(const double* p) { return _mm256_loadu_pd(p); }
+};
+
+struct Avx2Int32 {
+    using Value = int32_t;
+    using Vector = __m256i;
+    static constexpr size_t lanes = 8;
+    static constexpr bool widens = true;
+    GWAYTOOL_AVX2 static Vector load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    GWAYTOOL_AVX2 static void store(int32_t* p, Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    GWAYTOOL_AVX2 static Vector fill(int32_t value) { return _mm256_set1_epi32(value); }
+    GWAYTOOL_AVX2 static Vector min(Vector a, Vector b) { return _mm256_min_epi32(a, b); }
+    GWAYTOOL_AVX2 static Vector max(Vector a, Vector b) { return _mm256_max_epi32(a, b); }
+    GWAYTOOL_AVX2 static __m256d widen(const int32_t* p) {
+        return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+};
+
+struct Avx2Int64 {
+    using Value = int64_t;
+    using Vector = __m256i;
+    static constexpr size_t lanes = 4;
+    static constexpr bool widens = false;
+    GWAYTOOL_AVX2 static Vector load(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    GWAYTOOL_AVX2 static void store(int64_t* p, Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    GWAYTOOL_AVX2 static Vector fill(int64_t value) { return _mm256_set1_epi64x(value); }
+    GWAYTOOL_AVX2 static Vector min(Vector a, Vector b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    GWAYTOOL_AVX2 static Vector max(Vector a, Vector b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+};
+
+template<typename Ops>
+GWAYTOOL_AVX2 void minMaxAvx2(const typename Ops::Value* values, size_t count,
+                              typename Ops::Value& low, typename Ops::Value& high) {
+    using Value = typename Ops::Value;
+    if (count < Ops::lanes * 2) {
+        minMaxScalar(values, count, low, high);
+        return;
+    }
+
+    // Two accumulators each, to overlap the compare latency. They start from
+    // the first value, which minMaxOf made a number, in every lane.
+    typename Ops::Vector lows[2] = {Ops::fill(values[0]), Ops::fill(values[0])};
+    typename Ops::Vector highs[2] = {lows[0], lows[1]};
+    size_t i = 0;
+    for (; i + Ops::lanes * 2 <= count; i += Ops::lanes * 2) {
+        typename Ops::Vector first = Ops::load(values + i);
+        typename Ops::Vector second = Ops::load(values + i + Ops::lanes);
+        lows[0] = Ops::min(lows[0], first);
+        highs[0] = Ops::max(highs[0], first);
+        lows[1] = Ops::min(lows[1], second);
+        highs[1] = Ops::max(highs[1], second);
+    }
+
+    Value laneLows[Ops::lanes], laneHighs[Ops::lanes];
+    Ops::store(laneLows, Ops::min(lows[0], lows[1]));
+    Ops::store(laneHighs, Ops::max(highs[0], highs[1]));
+    low = laneLows[0];
+    high = laneHighs[0];
+    for (size_t lane = 1; lane < Ops::lanes; ++lane) {
+        low = std::min(low, laneLows[lane]);
+        high = std::max(high, laneHighs[lane]);
+    }
+    for (; i < count; ++i) {
+        low = std::min(low, values[i]);
+        high = std::max(high, values[i]);
+    }
+}
+
+template<typename Ops>
+GWAYTOOL_AVX2 double sumAvx2(const typename Ops::Value* values, size_t count) {
+    __m256d totals[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        totals[0] = _mm256_add_pd(totals[0], Ops::widen(values + i));
+        totals[1] = _mm256_add_pd(totals[1], Ops::widen(values + i + 4));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(totals[0], totals[1]));
+    double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; ++i) {
+        total += static_cast<double>(values[i]);
+    }
+    return total;
+}
+
+template<typename Ops>
+GWAYTOOL_AVX2 void transformAvx2(const typename Ops::Value* values, size_t count, double scale, double offset,
+                                 float* out) {
+    __m256d scales = _mm256_set1_pd(scale);
+    __m256d offsets = _mm256_set1_pd(offset);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d mapped = _mm256_add_pd(offsets, _mm256_mul_pd(Ops::widen(values + i), scales));
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(mapped));
+    }
+    transformScalar(values + i, count - i, scale, offset, out + i);
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+template<typename Ops>
+Kernels<typename Ops::Value> pickKernels() {
+    using Value = typename Ops::Value;
+    if (!hasAvx2()) {
+        return {minMaxScalar<Value>, sumScalar<Value>, transformScalar<Value>};
+    }
+    if constexpr (Ops::widens) {
+        return {minMaxAvx2<Ops>, sumAvx2<Ops>, transformAvx2<Ops>};
+    } else {
+        return {minMaxAvx2<Ops>, sumScalar<Value>, transformScalar<Value>};
+    }
+}
+
+template<ChartValue T>
+const Kernels<T>& kernels() {
+    static const Kernels<T> selected = [] {
+        if constexpr (std::is_same_v<T, float>) return pickKernels<Avx2Float>();
+        else if constexpr (std::is_same_v<T, double>) return pickKernels<Avx2Double>();
+        else if constexpr (std::is_same_v<T, int32_t>) return pickKernels<Avx2Int32>();
+        else return pickKernels<Avx2Int64>();
+    }();
+    return selected;
+}
+
+#elif defined(GWAYTOOL_KERNELS_NEON)
+
+// NEON is always there on AArch64, so nothing is chosen at run time. min
+// and max are std::min and std::max lane by lane, as on AVX2.
+struct NeonFloat {
+    using Value = float;
+    using Vector = float32x4_t;
+    static constexpr size_t lanes = 4;
+    static Vector load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, Vector v) { vst1q_f32(p, v); }
+    static Vector fill(float value) { return vdupq_n_f32(value); }
+    // vminq and vmaxq would return NaN when either lane is NaN.
+    static Vector min(Vector a, Vector b) { return vbslq_f32(vcltq_f32(b, a), b, a); }
+    static Vector max(Vector a, Vector b) { return vbslq_f32(vcltq_f32(a, b), b, a); }
+    static float64x2_t widen(const float* p) { return vcvt_f64_f32(vld1_f32(p)); }
+};
+
+struct NeonDouble {
+    using Value = double;
+    using Vector = float64x2_t;
+    static constexpr size_t lanes = 2;
+    static Vector load(const double* p) { return vld1q_f64(p); }
+    static void store(double* p, Vector v) { vst1q_f64(p, v); }
+    static Vector fill(double value) { return vdupq_n_f64(value); }
+    static Vector min(Vector a, Vector b) { return vbslq_f64(vcltq_f64(b, a), b, a); }
+    static Vector max(Vector a, Vector b) { return vbslq_f64(vcltq_f64(a, b), b, a); }
+    static float64x2_t widen(const double* p) { return vld1q_f64(p); }
+};
+
+struct NeonInt32 {
+    using Value = int32_t;
+    using Vector = int32x4_t;
+    static constexpr size_t lanes = 4;
+    static Vector load(const int32_t* p) { return vld1q_s32(p); }
+    static void store(int32_t* p, Vector v) { vst1q_s32(p, v); }
+    static Vector fill(int32_t value) { return vdupq_n_s32(value); }
+    static Vector min(Vector a, Vector b) { return vminq_s32(a, b); }
+    static Vector max(Vector a, Vector b) { return vmaxq_s32(a, b); }
+    static float64x2_t widen(const int32_t* p) { return vcvtq_f64_s64(vmovl_s32(vld1_s32(p))); }
+};
+
+struct NeonInt64 {
+    using Value = int64_t;
+    using Vector = int64x2_t;
+    static constexpr size_t lanes = 2;
+    static Vector load(const int64_t* p) { return vld1q_s64(p); }
+    static void store(int64_t* p, Vector v) { vst1q_s64(p, v); }
+    static Vector fill(int64_t value) { return vdupq_n_s64(value); }
+    static Vector min(Vector a, Vector b) { return vbslq_s64(vcgtq_s64(a, b), b, a); }
+    static Vector max(Vector a, Vector b) { return vbslq_s64(vcgtq_s64(a, b), a, b); }
+    static float64x2_t widen(const int64_t* p) { return vcvtq_f64_s64(vld1q_s64(p)); }
+};
+
+template<typename Ops>
+void minMaxNeon(const typename Ops::Value* values, size_t count, typename Ops::Value& low, typename Ops::Value& high) {
+    using Value = typename Ops::Value;
+    if (count < Ops::lanes) {
+        minMaxScalar(values, count, low, high);
+        return;
+    }
+
+    typename Ops::Vector lows = Ops::fill(values[0]);
+    typename Ops::Vector highs = lows;
+    size_t i = 0;
+    for (; i + Ops::lanes <= count; i += Ops::lanes) {
+        typename Ops::Vector next = Ops::load(values + i);
+        lows = Ops::min(lows, next);
+        highs = Ops::max(highs, next);
+    }
+
+    Value laneLows[Ops::lanes], laneHighs[Ops::lanes];
+    Ops::store(laneLows, lows);
+    Ops::store(laneHighs, highs);
+    low = laneLows[0];
+    high = laneHighs[0];
+    for (size_t lane = 1; lane < Ops::lanes; ++lane) {
+        low = std::min(low, laneLows[lane]);
+        high = std::max(high, laneHighs[lane]);
+    }
+    for (; i < count; ++i) {
+        low = std::min(low, values[i]);
+        high = std::max(high, values[i]);
+    }
+}
+
+template<typename Ops>
+double sumNeon(const typename Ops::Value* values, size_t count) {
+    float64x2_t totals = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        totals = vaddq_f64(totals, Ops::widen(values + i));
+    }
+    double total = vaddvq_f64(totals);
+    for (; i < count; ++i) {
+        total += static_cast<double>(values[i]);
+    }
+    return total;
+}
+
+template<typename Ops>
+void transformNeon(const typename Ops::Value* values, size_t count, double scale, double offset, float* out) {
+    float64x2_t scales = vdupq_n_f64(scale);
+    float64x2_t offsets = vdupq_n_f64(offset);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float64x2_t mapped = vfmaq_f64(offsets, Ops::widen(values + i), scales);
+        vst1_f32(out + i, vcvt_f32_f64(mapped));
+    }
+    transformScalar(values + i, count - i, scale, offset, out + i);
+}
+
+template<ChartValue T>
+const Kernels<T>& kernels() {
+    using Ops = std::conditional_t<std::is_same_v<T, float>, NeonFloat,
+                std::conditional_t<std::is_same_v<T, double>, NeonDouble,
+                std::conditional_t<std::is_same_v<T, int32_t>, NeonInt32, NeonInt64>>>;
+    static const Kernels<T> selected = {minMaxNeon<Ops>, sumNeon<Ops>, transformNeon<Ops>};
+    return selected;
+}
+
+#else
+
+template<ChartValue T>
+const Kernels<T>& kernels() {
+    static const Kernels<T> selected = {minMaxScalar<T>, sumScalar<T>, transformScalar<T>};
+    return selected;
+}
+
+#endif
+
+}
+
+template<ChartValue T>
+std::pair<T, T> minMaxOf(std::span<const T> values) {
+    if constexpr (std::is_floating_point_v<T>) {
+        // Every kernel keeps what it has against a NaN, so starting them on a
+        // number skips NaN throughout.
+        auto number = std::find_if(values.begin(), values.end(), [](T value) { return !std::isnan(value); });
+        if (number == values.end()) return {values[0], values[0]};
+        values = values.subspan(static_cast<size_t>(number - values.begin()));
+    }
+    T low, high;
+    kernels<T>().minMax(values.data(), values.size(), low, high);
+    return {low, high};
+}
+
+template<ChartValue T>
+double sumOf(std::span<const T> values) {
+    return kernels<T>().sum(values.data(), values.size());
+}
+
+template<ChartValue T>
+void affineTransform(std::span<const T> values, double scale, double offset, std::span<float> out) {
+    kernels<T>().transform(values.data(), values.size(), scale, offset, out.data());
+}
+
+template<ChartValue T>
+void affineGather(std::span<const T> values, std::span<const size_t> indices, double scale, double offset,
+                  std::span<float> out) {
+    // Scattered loads gain nothing from vectors, and decimated series are short.
+    for (size_t n = 0; n < indices.size(); ++n) {
+        out[n] = static_cast<float>(offset + scale * static_cast<double>(values[indices[n]]));
+    }
+}
+
+const char* chartKernelIsa() {
+#if defined(GWAYTOOL_KERNELS_AVX2)
+    return hasAvx2() ? "avx2" : "scalar";
+#elif defined(GWAYTOOL_KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+#define GWAYTOOL_KERNELS(T) \
+    template std::pair<T, T> minMaxOf<T>(std::span<const T>); \
+    template double sumOf<T>(std::span<const T>); \
+    template void affineTransform<T>(std::span<const T>, double, double, std::span<float>); \
+    template void affineGather<T>(std::span<const T>, std::span<const size_t>, double, double, std::span<float>);
+
+GWAYTOOL_KERNELS(int32_t)
+GWAYTOOL_KERNELS(int64_t)
+GWAYTOOL_KERNELS(float)
+GWAYTOOL_KERNELS(double)
+
+#undef GWAYTOOL_KERNELS
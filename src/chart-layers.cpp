@@ -0,0 +1,57 @@
+#include "chart-layers.h"
+#include <algorithm>
+#include <cmath>
+
+const ChartLayerCache::Layer* ChartLayerCache::find(const std::string& key) {
+    for (Layer& layer : layers) {
+        if (layer.key == key) {
+            layer.lastUse = ++uses;
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+const ChartLayerCache::Layer& ChartLayerCache::store(cairo_surface_t* target, const std::string& key,
+                                                      cairo_surface_t* recording) {
+    double x, y, width, height;
+    cairo_recording_surface_ink_extents(recording, &x, &y, &width, &height);
+    // Whole pixels, so the layer is painted back without resampling.
+    int left = static_cast<int>(std::floor(x));
+    int top = static_cast<int>(std::floor(y));
+    Rect bounds{left, top,
+                std::max(static_cast<int>(std::ceil(x + width)) - left, 1),
+                std::max(static_cast<int>(std::ceil(y + height)) - top, 1)};
+
+    cairo_surface_t* surface = cairo_surface_create_similar(target, CAIRO_CONTENT_COLOR_ALPHA,
+                                                            bounds.width, bounds.height);
+    cairo_t* cr = cairo_create(surface);
+    cairo_set_source_surface(cr, recording, -bounds.x, -bounds.y);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_destroy(recording);
+
+    if (layers.size() >= capacity) {
+        auto oldest = std::min_element(layers.begin(), layers.end(), [](const Layer& a, const Layer& b) {
+            return a.lastUse < b.lastUse;
+        });
+        cairo_surface_destroy(oldest->surface);
+        *oldest = Layer{key, bounds, surface, ++uses};
+        return *oldest;
+    }
+    layers.push_back(Layer{key, bounds, surface, ++uses});
+    return layers.back();
+}
+
+void ChartLayerCache::paintLayer(cairo_t* cr, const Layer& layer) {
+    cairo_set_source_surface(cr, layer.surface, layer.bounds.x, layer.bounds.y);
+    cairo_rectangle(cr, layer.bounds.x, layer.bounds.y, layer.bounds.width, layer.bounds.height);
+    cairo_fill(cr);
+}
+
+void ChartLayerCache::clear() {
+    for (Layer& layer : layers) {
+        cairo_surface_destroy(layer.surface);
+    }
+    layers.clear();
+}
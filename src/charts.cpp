@@ -1,7 +1,116 @@
+#include <cmath>
+#include <cstdio>
 #include <numeric>
 #include "application.h"
+#include "chart-kernels.h"
 
-void CairoRenderer::drawBarChart(const std::vector<int>& values, int x, int y, int width, int height,
+namespace {
+
+// Affine map from values to screen y: 0 on the baseline at bottom, max at
+// top, which is height pixels up.
+struct VerticalScale {
+    double scale;
+    double offset;
+
+    template<ChartValue T>
+    VerticalScale(T max, double bottom, double height)
+            : scale(max != T{0} ? -height / static_cast<double>(max) : 0.0), offset(bottom) {
+    }
+};
+
+// Closest line chart points still get a marker, and labels.
+constexpr double min_marker_spacing = 8.0;
+constexpr double min_label_spacing = 30.0;
+// Rows of y axis labels, leaving room for their height; clear space kept
+// around every label; and the arc a pie slice needs at its label to get one.
+constexpr double min_row_spacing = 20.0;
+constexpr double label_gap = 4.0;
+constexpr double min_slice_label_arc = 8.0;
+// How far from a point the pointer still hovers it.
+constexpr float hover_radius = 12.0f;
+
+void drawChartAxes(cairo_t* cr, int x, int y, int width, int height) {
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_set_line_width(cr, 2.0);
+    cairo_move_to(cr, x, y + height);
+    cairo_line_to(cr, x + width, y + height);
+    cairo_move_to(cr, x, y);
+    cairo_line_to(cr, x, y + height);
+    cairo_stroke(cr);
+}
+
+// Centered on center_x, with its baseline at baseline_y.
+void drawChartTitle(cairo_t* cr, const std::optional<std::string>& title, double center_x, double baseline_y) {
+    if (!title || title->empty()) return;
+
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 16);
+
+    cairo_text_extents_t extents;
+    cairo_text_extents(cr, title->c_str(), &extents);
+
+    cairo_move_to(cr, center_x - (extents.width / 2.0), baseline_y);
+    cairo_show_text(cr, title->c_str());
+}
+
+template<ChartValue T>
+std::string formatValue(T value) {
+    if constexpr (std::is_integral_v<T>) {
+        return std::to_string(value);
+    } else {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+        return buffer;
+    }
+}
+
+std::string formatValue(const HoverValue& value) {
+    return std::visit([](auto held) { return formatValue(held); }, value);
+}
+
+template<ChartValue T>
+HoverValue hoverValue(T value) {
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<int64_t>(value);
+    } else {
+        return static_cast<double>(value);
+    }
+}
+
+// Ticks of a value axis from 0 up to max at a nice step, as many as fit in
+// height, the last one at or above max. Scaling to the last tick labels the
+// top of the axis and moves the scale only when the ticks change.
+std::vector<double> valueAxisTicks(double max, int height) {
+    size_t steps = std::max<size_t>(1, static_cast<size_t>(height / min_row_spacing));
+    double step = niceStep(max, steps);
+    if (step == 0.0) return {max};
+    std::vector<double> ticks = niceTicks(0.0, max, steps);
+    if (ticks.back() < max - step * 1e-9) {
+        // Ticks start at 0, so the next one is the count of them in steps.
+        ticks.push_back(static_cast<double>(ticks.size()) * step);
+    }
+    return ticks;
+}
+
+// Stride between the labelled ones of count evenly spaced items, so their
+// labels stay min_label_spacing apart at least; a nice number, never 0.
+size_t labelStride(size_t count, int width) {
+    size_t labels = std::max<size_t>(1, static_cast<size_t>(width / min_label_spacing));
+    return std::max<size_t>(1, static_cast<size_t>(niceStep(static_cast<double>(count), labels)));
+}
+
+void drawLabels(cairo_t* cr, const std::vector<PlacedLabel>& labels) {
+    for (const PlacedLabel& label : labels) {
+        cairo_move_to(cr, label.x, label.y);
+        cairo_show_text(cr, label.text.c_str());
+    }
+}
+
+}
+
+template<ChartValue T>
+void CairoRenderer::drawBarChart(std::span<const T> values, int x, int y, int width, int height,
                                  double r, double g, double b,
                                  const std::optional<std::vector<std::string>> &optionalLabels,
                                  const std::optional<std::string> &title) {
@@ -9,118 +118,278 @@ void CairoRenderer::drawBarChart(const std::vector<int>& values, int x, int y, i
     if (optionalLabels && !optionalLabels->empty() && values.size() != optionalLabels->size()) return;
 
     cairo_t* cr = cairo_create(cairo_surface);
+    // Nothing to hover on a bar chart; a chart it covers is gone.
+    forgetHoverTargets({x, y, width, height});
 
     int bar_count = values.size();
     int spacing = 10;
-    int bar_width = (width - spacing * (bar_count - 1)) / bar_count;
+    double bar_width = static_cast<double>(width - spacing * (bar_count - 1)) / bar_count;
 
-    int max_value = *std::max_element(values.begin(), values.end());
-    if (max_value == 0) max_value = 1;
+    T max_value = minMaxOf(values).second;
+    if (max_value == T{0}) max_value = T{1};
+    std::vector<double> y_ticks = valueAxisTicks(static_cast<double>(max_value), height);
+    VerticalScale scale(y_ticks.back(), y + height, height);
+    std::vector<float> bar_tops(values.size());
+    affineTransform(values, scale.scale, scale.offset, std::span<float>(bar_tops));
 
+    // All bars share a colour, so they are filled as one path.
     cairo_set_source_rgb(cr, r, g, b);
-
     for (int i = 0; i < bar_count; ++i) {
-        double bar_height = (static_cast<double>(values[i]) / max_value) * height;
-
-        int bar_x = x + i * (bar_width + spacing);
-        int bar_y = y + (height - bar_height);
-        cairo_rectangle(cr, bar_x, bar_y, bar_width, bar_height);
-        cairo_fill(cr);
+        double bar_x = x + i * (bar_width + spacing);
+        double bar_y = bar_tops[i];
+        cairo_rectangle(cr, bar_x, bar_y, bar_width, y + height - bar_y);
     }
+    cairo_fill(cr);
+
+    // Labels for every stride-th bar and every tick, without those that
+    // would overprint, so dense bars cost no more text than sparse ones.
+    size_t stride = labelStride(values.size(), width);
+    std::vector<PlacedLabel> x_labels;
+    for (size_t i = 0; i < values.size(); i += stride) {
+        std::string label = optionalLabels && !optionalLabels->empty() ? (*optionalLabels)[i] : std::to_string(i + 1);
+        double tick_x = x + static_cast<double>(i) * (bar_width + spacing) + bar_width / 2;
+        x_labels.push_back(labelExtents.place(std::move(label), tick_x, y + height + 20, LabelAnchor::Baseline));
+    }
+    cullOverlapping(x_labels, label_gap);
+    std::vector<PlacedLabel> y_labels;
+    for (double tick : y_ticks) {
+        double tick_y = scale.scale * tick + scale.offset;
+        y_labels.push_back(labelExtents.place(formatValue(tick), x - 10, tick_y, LabelAnchor::Right));
+    }
+    cullOverlapping(y_labels, label_gap);
 
-    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-    cairo_set_line_width(cr, 2.0);
+    std::string key = chartLayerKey("bar", x, y, width, height, bar_count, formatValue(y_ticks.back()),
+                                    title.value_or(""));
+    for (const PlacedLabel& label : y_labels) key += chartLayerKey(label.text);
+    key += chartLayerKey("columns");
+    for (const PlacedLabel& label : x_labels) key += chartLayerKey(label.text);
 
-    cairo_move_to(cr, x, y + height);
-    cairo_line_to(cr, x + width, y + height);
-    cairo_stroke(cr);
+    chartLayers.paint(cr, key, [&](cairo_t* cr) {
+        // Axes and every tick in one stroke, then the labels.
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_set_line_width(cr, 2.0);
 
-    cairo_move_to(cr, x, y);
-    cairo_line_to(cr, x, y + height);
-    cairo_stroke(cr);
+        cairo_move_to(cr, x, y + height);
+        cairo_line_to(cr, x + width, y + height);
+        cairo_move_to(cr, x, y);
+        cairo_line_to(cr, x, y + height);
 
-    int y_ticks = 5;
-    for (int i = 0; i <= y_ticks; ++i) {
-        int tick_y = y + height - (height * i / y_ticks);
-        cairo_move_to(cr, x - 5, tick_y);
-        cairo_line_to(cr, x + 5, tick_y);
+        for (double tick : y_ticks) {
+            double tick_y = scale.scale * tick + scale.offset;
+            cairo_move_to(cr, x - 5, tick_y);
+            cairo_line_to(cr, x + 5, tick_y);
+        }
+        for (size_t i = 0; i < values.size(); i += stride) {
+            double tick_x = x + static_cast<double>(i) * (bar_width + spacing) + bar_width / 2;
+            cairo_move_to(cr, tick_x, y + height + 5);
+            cairo_line_to(cr, tick_x, y + height - 5);
+        }
         cairo_stroke(cr);
 
-        std::string label = std::to_string(i * max_value / y_ticks);
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_move_to(cr, x - 30, tick_y + 5);
-        cairo_show_text(cr, label.c_str());
-    }
+        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 12);
+        drawLabels(cr, y_labels);
+        drawLabels(cr, x_labels);
 
-    for (int i = 0; i < bar_count; ++i) {
-        int tick_x = x + i * (bar_width + spacing) + bar_width / 2;
-        cairo_move_to(cr, tick_x, y + height + 5);
-        cairo_line_to(cr, tick_x, y + height - 5);
-        cairo_stroke(cr);
+        drawChartTitle(cr, title, x + (width / 2.0), y - 20);
+    });
+
+    present();
+    cairo_destroy(cr);
+}
+
+
+
+template<ChartValue X, ChartValue Y>
+void CairoRenderer::drawLineChart(std::span<const X> x_values, std::span<const Y> y_values, int x, int y, int width, int height,
+                                  double r, double g, double b,
+                                  const std::optional<std::string> &title, Decimation decimation) {
+    if (x_values.empty() || y_values.empty() || x_values.size() != y_values.size()) return;
+
+    cairo_t* cr = cairo_create(cairo_surface);
+
+    Y max_value = minMaxOf(y_values).second;
+    if (max_value == Y{0}) max_value = Y{1};
+    std::vector<double> y_ticks = valueAxisTicks(static_cast<double>(max_value), height);
+    VerticalScale scale(y_ticks.back(), y + height, height);
 
-        std::string label;
-        if (optionalLabels && !optionalLabels->empty()) {
-            label = (*optionalLabels)[i];
+    size_t point_count = x_values.size();
+    double spacing = point_count > 1 ? static_cast<double>(width) / static_cast<double>(point_count - 1) : 0.0;
+
+    // More points than pixel columns only cost path segments, so the path is
+    // built from the decimated series, bounding its size by the width.
+    std::vector<size_t> path;
+    if (point_count > static_cast<size_t>(std::max(width, 1))) {
+        if (decimation == Decimation::Lttb) {
+            decimateLttb(y_values, 2 * static_cast<size_t>(width), path);
         } else {
-            label = std::to_string(i + 1);
+            decimateMinMax(y_values, static_cast<size_t>(width), path);
         }
+    }
 
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_move_to(cr, tick_x - 5, y + height + 20);
-        cairo_show_text(cr, label.c_str());
+    // Screen y of every path point, or of every point when nothing was dropped.
+    std::vector<float> screen_y(path.empty() ? point_count : path.size());
+    if (path.empty()) {
+        affineTransform(y_values, scale.scale, scale.offset, std::span<float>(screen_y));
+    } else {
+        affineGather(y_values, std::span<const size_t>(path), scale.scale, scale.offset, std::span<float>(screen_y));
     }
 
-    if (title && !title->empty()) {
+    // The points as drawn, so the tooltip names the ones that can be seen.
+    HoverIndex& hover = hoverTargetFor({x, y, width, height});
+    hover.reserve(screen_y.size());
+    for (size_t n = 0; n < screen_y.size(); ++n) {
+        size_t i = path.empty() ? n : path[n];
+        hover.add({static_cast<float>(x + static_cast<double>(i) * spacing), screen_y[n],
+                   hoverValue(x_values[i]), hoverValue(y_values[i])});
+    }
+
+    // The x values of every stride-th point and the value ticks, without
+    // labels that would overprint, so text stays bounded by the chart size.
+    size_t stride = labelStride(point_count - 1, width);
+    std::vector<PlacedLabel> x_labels;
+    for (size_t i = 0; i < point_count; i += stride) {
+        x_labels.push_back(labelExtents.place(formatValue(x_values[i]), x + static_cast<double>(i) * spacing,
+                                              y + height + 20, LabelAnchor::Baseline));
+    }
+    cullOverlapping(x_labels, label_gap);
+    std::vector<PlacedLabel> y_labels;
+    for (double tick : y_ticks) {
+        double tick_y = scale.scale * tick + scale.offset;
+        y_labels.push_back(labelExtents.place(formatValue(tick), x - 10, tick_y, LabelAnchor::Right));
+    }
+    cullOverlapping(y_labels, label_gap);
+
+    std::string key = chartLayerKey("line", x, y, width, height, point_count, formatValue(y_ticks.back()),
+                                    title.value_or(""));
+    for (const PlacedLabel& label : y_labels) key += chartLayerKey(label.text);
+    key += chartLayerKey("columns");
+    for (const PlacedLabel& label : x_labels) key += chartLayerKey(label.text);
+
+    chartLayers.paint(cr, key, [&](cairo_t* cr) {
+        drawChartAxes(cr, x, y, width, height);
+
+        // Ticks in one stroke, then the labels.
         cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(cr, 16);
+        for (size_t i = 0; i < point_count; i += stride) {
+            double point_x = x + static_cast<double>(i) * spacing;
+            cairo_move_to(cr, point_x, y + height);
+            cairo_line_to(cr, point_x, y + height + 5);
+        }
+        for (double tick : y_ticks) {
+            double tick_y = scale.scale * tick + scale.offset;
+            cairo_move_to(cr, x - 5, tick_y);
+            cairo_line_to(cr, x + 5, tick_y);
+        }
+        cairo_stroke(cr);
 
-        cairo_text_extents_t extents;
-        cairo_text_extents(cr, title->c_str(), &extents);
+        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 12);
+        drawLabels(cr, y_labels);
+        drawLabels(cr, x_labels);
+
+        drawChartTitle(cr, title, x + (width / 2.0), y - 20);
+    });
+
+    cairo_set_source_rgb(cr, r, g, b);
+    cairo_set_line_width(cr, 2.0);
 
-        double title_x = x + (width / 2.0) - (extents.width / 2.0);
-        double title_y = y - 20;
+    for (size_t n = 0; n < screen_y.size(); ++n) {
+        size_t i = path.empty() ? n : path[n];
+        double point_x = x + static_cast<double>(i) * spacing;
+        double point_y = screen_y[n];
+
+        if (n == 0) {
+            cairo_move_to(cr, point_x, point_y);
+        } else {
+            cairo_line_to(cr, point_x, point_y);
+        }
+    }
+    cairo_stroke(cr);
 
-        cairo_move_to(cr, title_x, title_y);
-        cairo_show_text(cr, title->c_str());
+    // Markers only while they stay apart, and so never for a decimated path.
+    if (spacing >= min_marker_spacing && path.empty()) {
+        cairo_set_source_rgb(cr, r, g, b);
+        for (size_t i = 0; i < point_count; ++i) {
+            cairo_new_sub_path(cr);
+            cairo_arc(cr, x + static_cast<double>(i) * spacing, screen_y[i], 3, 0, 2 * M_PI);
+        }
+        cairo_fill(cr);
     }
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
     cairo_destroy(cr);
 }
 
 
-
-void CairoRenderer::drawLineChart(const std::vector<int>& x_values, const std::vector<int>& y_values, int x, int y, int width, int height,
+template<ChartValue Y>
+void CairoRenderer::drawLineChart(const SeriesPyramid<Y>& series, size_t first, size_t last, int x, int y, int width, int height,
                                   double r, double g, double b,
                                   const std::optional<std::string> &title) {
-    if (x_values.empty() || y_values.empty() || x_values.size() != y_values.size()) return;
+    last = std::min(last, series.size());
+    if (first >= last) return;
 
     cairo_t* cr = cairo_create(cairo_surface);
 
-    double max_value = *std::max_element(y_values.begin(), y_values.end());
-    if (max_value == 0) max_value = 1;
+    Y max_value = series.range(first, last).second;
+    if (max_value == Y{0}) max_value = Y{1};
+    VerticalScale scale(max_value, y + height, height);
 
-    int point_count = x_values.size();
-    int spacing = width / (point_count - 1);
+    size_t point_count = last - first;
+    double spacing = point_count > 1 ? static_cast<double>(width) / static_cast<double>(point_count - 1) : 0.0;
 
-    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-    cairo_set_line_width(cr, 2.0);
-    cairo_move_to(cr, x, y + height);
-    cairo_line_to(cr, x + width, y + height);
-    cairo_move_to(cr, x, y);
-    cairo_line_to(cr, x, y + height);
-    cairo_stroke(cr);
+    std::vector<size_t> path;
+    series.window(first, last, static_cast<size_t>(std::max(width, 1)), path);
 
-    cairo_set_source_rgb(cr, r, g, b);
-    cairo_set_line_width(cr, 2.0);
+    std::vector<Y> path_values(path.size());
+    for (size_t n = 0; n < path.size(); ++n) {
+        path_values[n] = series.at(path[n]);
+    }
+    std::vector<float> screen_y(path.size());
+    affineTransform(std::span<const Y>(path_values), scale.scale, scale.offset, std::span<float>(screen_y));
+
+    // The window's first and last index under the axis, the top of the scale beside it.
+    std::string first_label = std::to_string(first);
+    std::string last_label = std::to_string(last - 1);
+    std::string max_label = formatValue(max_value);
+    std::string key = chartLayerKey("series", x, y, width, height, first_label, last_label, max_label,
+                                    title.value_or(""));
+
+    HoverIndex& hover = hoverTargetFor({x, y, width, height});
+    hover.reserve(path.size());
+    for (size_t n = 0; n < path.size(); ++n) {
+        hover.add({static_cast<float>(x + static_cast<double>(path[n] - first) * spacing), screen_y[n],
+                   hoverValue(static_cast<int64_t>(path[n])), hoverValue(path_values[n])});
+    }
+
+    chartLayers.paint(cr, key, [&](cairo_t* cr) {
+        drawChartAxes(cr, x, y, width, height);
+
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 12);
 
-    for (int i = 0; i < point_count; ++i) {
-        double value_height = (y_values[i] / max_value) * height;
-        double point_x = x + i * spacing;
-        double point_y = y + height - value_height;
+        cairo_text_extents_t extents;
+        cairo_move_to(cr, x, y + height + 20);
+        cairo_show_text(cr, first_label.c_str());
+
+        cairo_text_extents(cr, last_label.c_str(), &extents);
+        cairo_move_to(cr, x + width - extents.width, y + height + 20);
+        cairo_show_text(cr, last_label.c_str());
+
+        cairo_text_extents(cr, max_label.c_str(), &extents);
+        cairo_move_to(cr, x - 10 - extents.width, y + extents.height / 2.0);
+        cairo_show_text(cr, max_label.c_str());
+
+        drawChartTitle(cr, title, x + (width / 2.0), y - 20);
+    });
 
-        if (i == 0) {
+    cairo_set_source_rgb(cr, r, g, b);
+    cairo_set_line_width(cr, 2.0);
+    for (size_t n = 0; n < path.size(); ++n) {
+        double point_x = x + static_cast<double>(path[n] - first) * spacing;
+        double point_y = screen_y[n];
+        if (n == 0) {
             cairo_move_to(cr, point_x, point_y);
         } else {
             cairo_line_to(cr, point_x, point_y);
@@ -128,72 +397,196 @@ void CairoRenderer::drawLineChart(const std::vector<int>& x_values, const std::v
     }
     cairo_stroke(cr);
 
-    for (int i = 0; i < point_count; ++i) {
-        double value_height = (y_values[i] / max_value) * height;
-        double point_x = x + i * spacing;
-        double point_y = y + height - value_height;
-
-        cairo_arc(cr, point_x, point_y, 3, 0, 2 * M_PI);
+    if (spacing >= min_marker_spacing) {
+        for (size_t n = 0; n < path.size(); ++n) {
+            double point_x = x + static_cast<double>(path[n] - first) * spacing;
+            double point_y = screen_y[n];
+            cairo_new_sub_path(cr);
+            cairo_arc(cr, point_x, point_y, 3, 0, 2 * M_PI);
+        }
         cairo_fill(cr);
+    }
+
+    present();
+    cairo_destroy(cr);
+}
 
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_move_to(cr, point_x, y + height);
-        cairo_line_to(cr, point_x, y + height + 5);
-        cairo_stroke(cr);
 
-        std::string label = std::to_string(x_values[i]);
+template<ChartValue X, ChartValue Y>
+void CairoRenderer::drawScatterChart(std::span<const X> x_values, std::span<const Y> y_values, int x, int y,
+                                     int width, int height, double r, double g, double b,
+                                     const std::optional<std::string> &title, ScatterMode mode) {
+    if (x_values.empty() || x_values.size() != y_values.size() || width <= 0 || height <= 0) return;
+
+    auto [x_min, x_max] = minMaxOf(x_values);
+    auto [y_min, y_max] = minMaxOf(y_values);
+    scatterRaster.reset(width, height, static_cast<double>(x_min), static_cast<double>(x_max),
+                        static_cast<double>(y_min), static_cast<double>(y_max));
+    scatterRaster.add(x_values, y_values);
+
+    cairo_surface_t* image = chartImageFor(width, height);
+    scatterRaster.toneMap(mode, r, g, b, cairo_image_surface_get_data(image), cairo_image_surface_get_stride(image));
+    cairo_surface_mark_dirty(image);
+
+    // One point per pixel holding any: the rest are hidden under it.
+    HoverIndex& hover = hoverTargetFor({x, y, width, height});
+    const std::vector<size_t>& first_points = scatterRaster.getFirstPoints();
+    for (size_t pixel = 0; pixel < first_points.size(); ++pixel) {
+        size_t i = first_points[pixel];
+        if (i == ScatterRaster::noPoint) continue;
+        hover.add({static_cast<float>(x + static_cast<int>(pixel % width)) + 0.5f,
+                   static_cast<float>(y + static_cast<int>(pixel / width)) + 0.5f,
+                   hoverValue(x_values[i]), hoverValue(y_values[i])});
+    }
+
+    cairo_t* cr = cairo_create(cairo_surface);
+
+    // The ranges at the axis ends: minimum at the origin, maximum at the far end.
+    std::string x_min_label = formatValue(x_min);
+    std::string x_max_label = formatValue(x_max);
+    std::string y_min_label = formatValue(y_min);
+    std::string y_max_label = formatValue(y_max);
+    std::string key = chartLayerKey("scatter", x, y, width, height, x_min_label, x_max_label, y_min_label,
+                                    y_max_label, title.value_or(""));
+    chartLayers.paint(cr, key, [&](cairo_t* cr) {
+        drawChartAxes(cr, x, y, width, height);
+
         cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
         cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
         cairo_set_font_size(cr, 12);
 
         cairo_text_extents_t extents;
-        cairo_text_extents(cr, label.c_str(), &extents);
-        double text_x = point_x - extents.width / 2.0;
-        double text_y = y + height + 20;
+        cairo_move_to(cr, x, y + height + 20);
+        cairo_show_text(cr, x_min_label.c_str());
 
-        cairo_move_to(cr, text_x, text_y);
-        cairo_show_text(cr, label.c_str());
+        cairo_text_extents(cr, x_max_label.c_str(), &extents);
+        cairo_move_to(cr, x + width - extents.width, y + height + 20);
+        cairo_show_text(cr, x_max_label.c_str());
 
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_move_to(cr, x - 5, point_y);
-        cairo_line_to(cr, x + 5, point_y);
-        cairo_stroke(cr);
+        cairo_text_extents(cr, y_min_label.c_str(), &extents);
+        cairo_move_to(cr, x - 10 - extents.width, y + height);
+        cairo_show_text(cr, y_min_label.c_str());
 
-        std::string y_label = std::to_string(y_values[i]);
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-        cairo_set_font_size(cr, 12);
+        cairo_text_extents(cr, y_max_label.c_str(), &extents);
+        cairo_move_to(cr, x - 10 - extents.width, y + extents.height);
+        cairo_show_text(cr, y_max_label.c_str());
 
-        cairo_text_extents(cr, y_label.c_str(), &extents);
-        double y_label_x = x - 10 - extents.width;
-        double y_label_y = point_y + extents.height / 2.0;
+        drawChartTitle(cr, title, x + (width / 2.0), y - 20);
+    });
 
-        cairo_move_to(cr, y_label_x, y_label_y);
-        cairo_show_text(cr, y_label.c_str());
-    }
+    // One upload of the whole raster.
+    cairo_set_source_surface(cr, image, x, y);
+    cairo_rectangle(cr, x, y, width, height);
+    cairo_fill(cr);
 
+    present();
+    cairo_destroy(cr);
+}
+
+
+template<ChartValue T>
+void CairoRenderer::drawHeatmap(std::span<const T> values, size_t rows, size_t cols, int x, int y, int width, int height,
+                                const std::optional<std::vector<std::string>>& rowLabels,
+                                const std::optional<std::vector<std::string>>& columnLabels,
+                                const std::optional<std::string>& title, Colormap colormap) {
+    if (rows == 0 || cols == 0 || values.size() != rows * cols || width <= 0 || height <= 0) return;
+    if (rowLabels && !rowLabels->empty() && rowLabels->size() != rows) return;
+    if (columnLabels && !columnLabels->empty() && columnLabels->size() != cols) return;
+
+    auto [low, high] = minMaxOf(values);
+    std::string low_label = formatValue(low);
+    std::string high_label = formatValue(high);
+
+    // The colour bar and its labels take the right edge of the chart, so
+    // nothing is drawn outside x..x+width; the matrix gets what is left.
+    double label_width = std::max(labelExtents.measure(low_label).x_advance,
+                                  labelExtents.measure(high_label).x_advance);
+    int bar_x = x + width - 24 - static_cast<int>(std::ceil(label_width));
+    int body_width = bar_x - 10 - x;
+    if (body_width <= 0) return;
+
+    cairo_surface_t* image = chartImageFor(body_width, height);
+    renderHeatmap(values, rows, cols, static_cast<double>(low), static_cast<double>(high), colormap,
+                  cairo_image_surface_get_data(image), body_width, height, cairo_image_surface_get_stride(image));
+    cairo_surface_mark_dirty(image);
+
+    // Nothing to hover on a heatmap; a chart it covers is gone.
+    forgetHoverTargets({x, y, width, height});
+
+    cairo_t* cr = cairo_create(cairo_surface);
+
+    cairo_set_source_surface(cr, image, x, y);
+    cairo_rectangle(cr, x, y, body_width, height);
+    cairo_fill(cr);
+
+    // Every step-th label, so neighbours stay at least spacing apart.
+    auto labelStep = [](double pitch, double spacing) {
+        return pitch >= spacing ? size_t{1} : static_cast<size_t>(std::ceil(spacing / pitch));
+    };
+    double row_pitch = static_cast<double>(height) / static_cast<double>(rows);
+    double column_pitch = static_cast<double>(body_width) / static_cast<double>(cols);
+    size_t row_step = labelStep(row_pitch, 14.0);
+    size_t column_step = labelStep(column_pitch, min_label_spacing);
+
+    std::string key = chartLayerKey("heatmap", x, y, width, height, rows, cols, static_cast<int>(colormap),
+                                    low_label, high_label, title.value_or(""));
+    if (rowLabels) for (const std::string& label : *rowLabels) key += chartLayerKey(label);
+    key += chartLayerKey("columns");
+    if (columnLabels) for (const std::string& label : *columnLabels) key += chartLayerKey(label);
+
+    chartLayers.paint(cr, key, [&](cairo_t* cr) {
+        drawChartAxes(cr, x, y, body_width, height);
 
-    if (title && !title->empty()) {
         cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(cr, 16);
+        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 12);
 
         cairo_text_extents_t extents;
-        cairo_text_extents(cr, title->c_str(), &extents);
+        for (size_t row = 0; row < rows; row += row_step) {
+            std::string label = rowLabels && !rowLabels->empty() ? (*rowLabels)[row] : std::to_string(row);
+            cairo_text_extents(cr, label.c_str(), &extents);
+            double center_y = y + (static_cast<double>(row) + 0.5) * row_pitch;
+            cairo_move_to(cr, x - 10 - extents.width, center_y + extents.height / 2.0);
+            cairo_show_text(cr, label.c_str());
+        }
+        for (size_t column = 0; column < cols; column += column_step) {
+            std::string label = columnLabels && !columnLabels->empty() ? (*columnLabels)[column]
+                                                                       : std::to_string(column);
+            cairo_text_extents(cr, label.c_str(), &extents);
+            double center_x = x + (static_cast<double>(column) + 0.5) * column_pitch;
+            cairo_move_to(cr, center_x - extents.width / 2.0, y + height + 20);
+            cairo_show_text(cr, label.c_str());
+        }
+
+        // Colour bar from the lowest value at the bottom to the highest at the top.
+        const std::array<uint32_t, 256>& table = colormapTable(colormap);
+        cairo_pattern_t* gradient = cairo_pattern_create_linear(0, y + height, 0, y);
+        for (size_t i = 0; i < table.size(); i += 15) {
+            cairo_pattern_add_color_stop_rgb(gradient, static_cast<double>(i) / (table.size() - 1),
+                                             ((table[i] >> 16) & 0xff) / 255.0, ((table[i] >> 8) & 0xff) / 255.0,
+                                             (table[i] & 0xff) / 255.0);
+        }
+        cairo_set_source(cr, gradient);
+        cairo_rectangle(cr, bar_x, y, 10, height);
+        cairo_fill(cr);
+        cairo_pattern_destroy(gradient);
 
-        double title_x = x + (width / 2.0) - (extents.width / 2.0);
-        double title_y = y - 20;
+        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+        cairo_move_to(cr, bar_x + 14, y + 10);
+        cairo_show_text(cr, high_label.c_str());
+        cairo_move_to(cr, bar_x + 14, y + height);
+        cairo_show_text(cr, low_label.c_str());
 
-        cairo_move_to(cr, title_x, title_y);
-        cairo_show_text(cr, title->c_str());
-    }
+        drawChartTitle(cr, title, x + (body_width / 2.0), y - 20);
+    });
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
     cairo_destroy(cr);
 }
 
 
-void CairoRenderer::drawPieChart(const std::vector<int>& values, int x, int y, int radius,
+template<ChartValue T>
+void CairoRenderer::drawPieChart(std::span<const T> values, int x, int y, int radius,
                                  const std::vector<std::tuple<double, double, double>>& colors,
                                  const std::optional<std::vector<std::string>>& optionalLabels,
                                  const std::optional<std::string>& title) {
@@ -201,68 +594,251 @@ void CairoRenderer::drawPieChart(const std::vector<int>& values, int x, int y, i
     if (colors.size() != values.size()) return;
 
     cairo_t* cr = cairo_create(cairo_surface);
+    // Nothing to hover on a pie chart; a chart it covers is gone.
+    forgetHoverTargets({x - radius, y - radius, 2 * radius, 2 * radius});
 
-    int total_value = std::accumulate(values.begin(), values.end(), 0);
+    double total_value = sumOf(values);
     if (total_value == 0) total_value = 1;
 
-    double start_angle = 0.0;
+    std::vector<float> angles(values.size());
+    affineTransform(values, 2 * M_PI / total_value, 0.0, std::span<float>(angles));
 
+    std::vector<double> start_angles(values.size());
+    double start_angle = 0.0;
     for (size_t i = 0; i < values.size(); ++i) {
-        double angle = (static_cast<double>(values[i]) / total_value) * 2 * M_PI;
-        double end_angle = start_angle + angle;
+        start_angles[i] = start_angle;
+        start_angle += angles[i];
+    }
 
-        double r, g, b;
-        std::tie(r, g, b) = colors[i];
-        cairo_set_source_rgb(cr, r, g, b);
+    // Slices grouped by colour, one fill per colour.
+    std::vector<size_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&colors](size_t a, size_t b) { return colors[a] < colors[b]; });
 
+    for (size_t n = 0; n < order.size(); ++n) {
+        size_t i = order[n];
         cairo_move_to(cr, x, y);
-        cairo_arc(cr, x, y, radius, start_angle, end_angle);
+        cairo_arc(cr, x, y, radius, start_angles[i], start_angles[i] + angles[i]);
         cairo_close_path(cr);
-        cairo_fill(cr);
 
-        start_angle = end_angle;
+        if (n + 1 == order.size() || colors[order[n + 1]] != colors[i]) {
+            double r, g, b;
+            std::tie(r, g, b) = colors[i];
+            cairo_set_source_rgb(cr, r, g, b);
+            cairo_fill(cr);
+        }
     }
 
     if (optionalLabels && !optionalLabels->empty()) {
-        start_angle = 0.0;
-        for (size_t i = 0; i < values.size(); ++i) {
-            double angle = (static_cast<double>(values[i]) / total_value) * 2 * M_PI;
-            double middle_angle = start_angle + angle / 2.0;
-
+        // Largest slices first, so a label that would overprint gives way to
+        // a bigger slice's; slices too thin at the label radius get none.
+        std::vector<size_t> by_size(values.size());
+        std::iota(by_size.begin(), by_size.end(), 0);
+        std::stable_sort(by_size.begin(), by_size.end(), [&angles](size_t a, size_t b) { return angles[a] > angles[b]; });
+
+        std::vector<PlacedLabel> labels;
+        for (size_t i : by_size) {
+            if (angles[i] * radius * 0.6 < min_slice_label_arc) break;
+            double middle_angle = start_angles[i] + angles[i] / 2.0;
             double label_x = x + (radius * 0.6) * cos(middle_angle);
             double label_y = y + (radius * 0.6) * sin(middle_angle);
+            labels.push_back(labelExtents.place((*optionalLabels)[i], label_x, label_y, LabelAnchor::Center));
+        }
+        cullOverlapping(labels, label_gap);
+
+        cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(cr, 12);
+        drawLabels(cr, labels);
+    }
 
-            cairo_set_source_rgb(cr, 0.0, 0.0, 0.0); // White color for text
-            cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-            cairo_set_font_size(cr, 12);
+    if (title && !title->empty()) {
+        chartLayers.paint(cr, chartLayerKey("pie", x, y, radius, *title), [&](cairo_t* cr) {
+            drawChartTitle(cr, title, x + (radius / 2.0) - 30, y - radius - 20);
+        });
+    }
 
-            std::string label = (*optionalLabels)[i];
-            cairo_text_extents_t extents;
-            cairo_text_extents(cr, label.c_str(), &extents);
-            cairo_move_to(cr, label_x - extents.width / 2, label_y + extents.height / 2);
-            cairo_show_text(cr, label.c_str());
+    present();
+    cairo_destroy(cr);
+}
 
-            start_angle += angle;
-        }
+
+#define GWAYTOOL_XY_CHARTS(X, Y) \
+    template void CairoRenderer::drawLineChart<X, Y>(std::span<const X>, std::span<const Y>, int, int, int, int, \
+                                                     double, double, double, const std::optional<std::string>&, \
+                                                     Decimation); \
+    template void CairoRenderer::drawScatterChart<X, Y>(std::span<const X>, std::span<const Y>, int, int, int, int, \
+                                                        double, double, double, const std::optional<std::string>&, \
+                                                        ScatterMode);
+#define GWAYTOOL_CHARTS(T) \
+    template void CairoRenderer::drawBarChart<T>(std::span<const T>, int, int, int, int, double, double, double, \
+                                                 const std::optional<std::vector<std::string>>&, \
+                                                 const std::optional<std::string>&); \
+    template void CairoRenderer::drawLineChart<T>(const SeriesPyramid<T>&, size_t, size_t, int, int, int, int, \
+                                                  double, double, double, const std::optional<std::string>&); \
+    template void CairoRenderer::drawHeatmap<T>(std::span<const T>, size_t, size_t, int, int, int, int, \
+                                                const std::optional<std::vector<std::string>>&, \
+                                                const std::optional<std::vector<std::string>>&, \
+                                                const std::optional<std::string>&, Colormap); \
+    template void CairoRenderer::drawPieChart<T>(std::span<const T>, int, int, int, \
+                                                 const std::vector<std::tuple<double, double, double>>&, \
+                                                 const std::optional<std::vector<std::string>>&, \
+                                                 const std::optional<std::string>&); \
+    GWAYTOOL_XY_CHARTS(T, int32_t) \
+    GWAYTOOL_XY_CHARTS(T, int64_t) \
+    GWAYTOOL_XY_CHARTS(T, float) \
+    GWAYTOOL_XY_CHARTS(T, double)
+
+GWAYTOOL_CHARTS(int32_t)
+GWAYTOOL_CHARTS(int64_t)
+GWAYTOOL_CHARTS(float)
+GWAYTOOL_CHARTS(double)
+
+#undef GWAYTOOL_CHARTS
+#undef GWAYTOOL_XY_CHARTS
+
+
+cairo_surface_t* CairoRenderer::chartImageFor(int width, int height) {
+    if (chartImage && (cairo_image_surface_get_width(chartImage) != width ||
+                       cairo_image_surface_get_height(chartImage) != height)) {
+        cairo_surface_destroy(chartImage);
+        chartImage = nullptr;
     }
+    if (!chartImage) {
+        chartImage = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    }
+    cairo_surface_flush(chartImage);
+    return chartImage;
+}
 
-    if (title && !title->empty()) {
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(cr, 16);
 
-        cairo_text_extents_t extents;
-        cairo_text_extents(cr, title->c_str(), &extents);
+HoverIndex& CairoRenderer::hoverTargetFor(const Rect& area) {
+    std::erase_if(hoverTargets, [&](const HoverTarget& target) {
+        return target.area != area && target.area.intersects(area);
+    });
+    auto target = std::find_if(hoverTargets.begin(), hoverTargets.end(),
+                               [&](const HoverTarget& target) { return target.area == area; });
+    if (target == hoverTargets.end()) {
+        target = hoverTargets.insert(hoverTargets.end(), HoverTarget{area, {}});
+    }
+    target->points.clear();
+    hoverTargetsChanged = true;
+    return target->points;
+}
 
-        double title_x = x + (radius / 2.0) - (extents.width / 2.0) - 30;
-        double title_y = y - radius - 20;
+void CairoRenderer::forgetHoverTargets(const Rect& area) {
+    std::erase_if(hoverTargets, [&](const HoverTarget& target) { return target.area.intersects(area); });
+    hoverTargetsChanged = true;
+}
 
-        cairo_move_to(cr, title_x, title_y);
-        cairo_show_text(cr, title->c_str());
+std::optional<HoverPoint> CairoRenderer::pointNear(int x, int y) {
+    std::optional<HoverPoint> nearest;
+    float nearest_distance = hover_radius;
+    auto px = static_cast<float>(x);
+    auto py = static_cast<float>(y);
+    for (HoverTarget& target : hoverTargets) {
+        if (!target.area.inflated(static_cast<int>(hover_radius)).contains(x, y)) continue;
+        const HoverPoint* point = target.points.nearest(px, py, nearest_distance);
+        if (!point) continue;
+        nearest = *point;
+        nearest_distance = std::hypot(point->x - px, point->y - py);
     }
+    return nearest;
+}
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
-    cairo_destroy(cr);
+bool CairoRenderer::updateHover(int x, int y) {
+    hoverX = x;
+    hoverY = y;
+    hoverTargetsChanged = false;
+    std::optional<HoverPoint> point = pointNear(x, y);
+    if (point == hovered) return false;
+    hovered = point;
+    return true;
+}
+
+void CairoRenderer::drawTooltip() {
+    present();
+}
+
+void CairoRenderer::hideTooltip(cairo_t* cr) {
+    if (tooltipBounds.empty()) return;
+    cairo_save(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cr, tooltipUnder, tooltipBounds.x, tooltipBounds.y);
+    cairo_rectangle(cr, tooltipBounds.x, tooltipBounds.y, tooltipBounds.width, tooltipBounds.height);
+    cairo_fill(cr);
+    cairo_restore(cr);
+    tooltipBounds = {};
+}
+
+void CairoRenderer::showTooltip(cairo_t* cr) {
+    if (!hovered) return;
+
+    // Written as the axes write values.
+    std::string text = "x: " + formatValue(hovered->valueX) + "  y: " + formatValue(hovered->valueY);
+
+    cairo_save(cr);
+    cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 12);
+    cairo_font_extents_t font;
+    cairo_font_extents(cr, &font);
+    cairo_text_extents_t extents;
+    cairo_text_extents(cr, text.c_str(), &extents);
+
+    // Above and right of the point, flipped to stay on the surface.
+    int surface_width = cairo_gl_surface_get_width(cairo_surface);
+    int surface_height = cairo_gl_surface_get_height(cairo_surface);
+    constexpr int padding = 4;
+    constexpr int offset = 10;
+    int point_x = static_cast<int>(std::lround(hovered->x));
+    int point_y = static_cast<int>(std::lround(hovered->y));
+    int box_width = static_cast<int>(std::ceil(extents.x_advance)) + 2 * padding;
+    int box_height = static_cast<int>(std::ceil(font.ascent + font.descent)) + 2 * padding;
+    int box_x = point_x + offset;
+    int box_y = point_y - offset - box_height;
+    if (box_x + box_width > surface_width) box_x = point_x - offset - box_width;
+    if (box_y < 0) box_y = point_y + offset;
+    Rect box{box_x, box_y, box_width, box_height};
+    Rect marker{point_x - 6, point_y - 6, 12, 12};
+
+    // Keeps what is about to be covered, for hideTooltip after the swap.
+    Rect bounds = box.inflated(1).united(marker);
+    bounds.x = std::max(bounds.x, 0);
+    bounds.y = std::max(bounds.y, 0);
+    bounds.width = std::min(bounds.x + bounds.width, surface_width) - bounds.x;
+    bounds.height = std::min(bounds.y + bounds.height, surface_height) - bounds.y;
+    if (tooltipUnder && (cairo_gl_surface_get_width(tooltipUnder) != bounds.width ||
+                         cairo_gl_surface_get_height(tooltipUnder) != bounds.height)) {
+        cairo_surface_destroy(tooltipUnder);
+        tooltipUnder = nullptr;
+    }
+    if (!tooltipUnder) {
+        tooltipUnder = cairo_surface_create_similar(cairo_surface, CAIRO_CONTENT_COLOR_ALPHA, bounds.width,
+                                                    bounds.height);
+    }
+    cairo_t* under = cairo_create(tooltipUnder);
+    cairo_set_operator(under, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(under, cairo_surface, -bounds.x, -bounds.y);
+    cairo_paint(under);
+    cairo_destroy(under);
+    tooltipBounds = bounds;
+
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_set_line_width(cr, 2.0);
+    cairo_new_sub_path(cr);
+    cairo_arc(cr, hovered->x, hovered->y, 4, 0, 2 * M_PI);
+    cairo_stroke(cr);
+
+    cairo_set_source_rgb(cr, 0.15, 0.15, 0.15);
+    cairo_rectangle(cr, box.x, box.y, box.width, box.height);
+    cairo_fill_preserve(cr);
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_set_line_width(cr, 1.0);
+    cairo_stroke(cr);
+
+    cairo_move_to(cr, box.x + padding - extents.x_bearing, box.y + padding + font.ascent);
+    cairo_show_text(cr, text.c_str());
+    cairo_restore(cr);
 }
 
 
@@ -292,20 +868,23 @@ void CairoRenderer::drawTable(const std::vector<std::vector<std::string>>& data,
 
     cairo_t* cr = cairo_create(cairo_surface);
 
+    // The whole grid is one path and one stroke.
+    cairo_set_source_rgb(cr, lineR, lineG, lineB);
     for (int i = 0; i <= rows; ++i) {
         int yOffset = y + i * cellHeight;
-        cairo_set_source_rgb(cr, lineR, lineG, lineB);
         cairo_move_to(cr, x, yOffset);
         cairo_line_to(cr, x + cols * cellWidth, yOffset);
-        cairo_stroke(cr);
     }
     for (int j = 0; j <= cols; ++j) {
         int xOffset = x + j * cellWidth;
-        cairo_set_source_rgb(cr, lineR, lineG, lineB);
         cairo_move_to(cr, xOffset, y);
         cairo_line_to(cr, xOffset, y + rows * cellHeight);
-        cairo_stroke(cr);
     }
+    cairo_stroke(cr);
+
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0); // White text
+    cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 12);
 
     for (int i = 0; i < rows; ++i) {
         for (int j = 0; j < cols; ++j) {
@@ -315,11 +894,7 @@ void CairoRenderer::drawTable(const std::vector<std::vector<std::string>>& data,
 //            cairo_fill(cr);
 
             // Draw text in the cell
-            cairo_set_source_rgb(cr, 1.0, 1.0, 1.0); // White text
-            cairo_select_font_face(cr, "Arial", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-            cairo_set_font_size(cr, 12);
-
-            std::string text = data[i][j];
+            const std::string& text = data[i][j];
             cairo_text_extents_t extents;
             cairo_text_extents(cr, text.c_str(), &extents);
 
@@ -331,7 +906,7 @@ void CairoRenderer::drawTable(const std::vector<std::vector<std::string>>& data,
         }
     }
 
-    cairo_gl_surface_swapbuffers(cairo_surface);
+    present();
     cairo_destroy(cr);
 }
 
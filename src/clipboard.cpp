@@ -0,0 +1,142 @@
+#include "clipboard.h"
+
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+// In order of preference.
+const char* const textMimeTypes[] = {
+        "text/plain;charset=utf-8",
+        "UTF8_STRING",
+        "text/plain",
+        "TEXT",
+        "STRING",
+};
+
+} // namespace
+
+const struct wl_data_device_listener Clipboard::data_device_listener = {
+        .data_offer = Clipboard::dataOfferHandler,
+        .enter = Clipboard::enterHandler,
+        .leave = Clipboard::leaveHandler,
+        .motion = Clipboard::motionHandler,
+        .drop = Clipboard::dropHandler,
+        .selection = Clipboard::selectionHandler,
+};
+
+const struct wl_data_offer_listener Clipboard::data_offer_listener = {
+        .offer = Clipboard::offerHandler,
+        .source_actions = [](void* data, struct wl_data_offer* offer, uint32_t actions) {
+        },
+        .action = [](void* data, struct wl_data_offer* offer, uint32_t action) {
+        },
+};
+
+Clipboard::~Clipboard() {
+    reset();
+}
+
+void Clipboard::reset() {
+    for (auto& [offer, mimeTypes] : offers) {
+        wl_data_offer_destroy(offer);
+    }
+    offers.clear();
+    selection = nullptr;
+    dragOffer = nullptr;
+}
+
+void Clipboard::setManager(struct wl_data_device_manager* dataDeviceManager) {
+    manager = dataDeviceManager;
+    createDevice();
+}
+
+void Clipboard::setSeat(struct wl_seat* wlSeat) {
+    seat = wlSeat;
+    createDevice();
+}
+
+void Clipboard::createDevice() {
+    if (device || !manager || !seat) return;
+    device = wl_data_device_manager_get_data_device(manager, seat);
+    wl_data_device_add_listener(device, &data_device_listener, this);
+}
+
+void Clipboard::dropOffer(struct wl_data_offer* offer) {
+    if (!offer) return;
+    offers.erase(offer);
+    wl_data_offer_destroy(offer);
+}
+
+const char* Clipboard::textMimeType() const {
+    auto it = offers.find(selection);
+    if (it == offers.end()) return nullptr;
+    for (const char* wanted : textMimeTypes) {
+        for (const std::string& mimeType : it->second) {
+            if (mimeType == wanted) return wanted;
+        }
+    }
+    return nullptr;
+}
+
+bool Clipboard::hasText() const {
+    return textMimeType() != nullptr;
+}
+
+int Clipboard::receiveText() {
+    const char* mimeType = textMimeType();
+    if (!mimeType) return -1;
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::cerr << "Failed to create a pipe for pasting.\n";
+        return -1;
+    }
+    wl_data_offer_receive(selection, mimeType, fds[1]);
+    close(fds[1]);
+    return fds[0];
+}
+
+void Clipboard::dataOfferHandler(void* data, struct wl_data_device* device, struct wl_data_offer* offer) {
+    auto* self = static_cast<Clipboard*>(data);
+    self->offers.emplace(offer, std::vector<std::string>{});
+    wl_data_offer_add_listener(offer, &data_offer_listener, self);
+}
+
+void Clipboard::offerHandler(void* data, struct wl_data_offer* offer, const char* mimeType) {
+    auto* self = static_cast<Clipboard*>(data);
+    auto it = self->offers.find(offer);
+    if (it != self->offers.end()) {
+        it->second.emplace_back(mimeType);
+    }
+}
+
+void Clipboard::selectionHandler(void* data, struct wl_data_device* device, struct wl_data_offer* offer) {
+    auto* self = static_cast<Clipboard*>(data);
+    if (self->selection != offer) {
+        self->dropOffer(self->selection);
+    }
+    self->selection = offer;
+}
+
+// Drag and drop is not supported, its offers are only released.
+void Clipboard::enterHandler(void* data, struct wl_data_device* device, uint32_t serial,
+                             struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y, struct wl_data_offer* offer) {
+    auto* self = static_cast<Clipboard*>(data);
+    self->dropOffer(self->dragOffer);
+    self->dragOffer = offer;
+}
+
+void Clipboard::leaveHandler(void* data, struct wl_data_device* device) {
+    auto* self = static_cast<Clipboard*>(data);
+    self->dropOffer(self->dragOffer);
+    self->dragOffer = nullptr;
+}
+
+void Clipboard::motionHandler(void* data, struct wl_data_device* device, uint32_t time, wl_fixed_t x, wl_fixed_t y) {
+}
+
+void Clipboard::dropHandler(void* data, struct wl_data_device* device) {
+    leaveHandler(data, device);
+}
@@ -0,0 +1,7 @@
+#include "dataset.h"
+#include <atomic>
+
+uint64_t nextDatasetVersion() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+#include "decimate.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+template<ChartValue T>
+void decimateMinMax(std::span<const T> values, size_t columns, std::vector<size_t>& out) {
+    size_t count = values.size();
+    if (count <= columns * 4 || columns == 0) {
+        size_t first = out.size();
+        out.resize(first + count);
+        std::iota(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), size_t{0});
+        return;
+    }
+
+    out.reserve(out.size() + columns * 4);
+    for (size_t column = 0; column < columns; ++column) {
+        size_t begin = column * count / columns;
+        size_t end = (column + 1) * count / columns;
+        if (begin == end) continue;
+
+        size_t low = begin, high = begin;
+        for (size_t i = begin + 1; i < end; ++i) {
+            if (values[i] < values[low]) low = i;
+            if (values[i] > values[high]) high = i;
+        }
+
+        size_t picks[4] = {begin, std::min(low, high), std::max(low, high), end - 1};
+        for (size_t i = 0; i < 4; ++i) {
+            if (i == 0 || picks[i] != picks[i - 1]) out.push_back(picks[i]);
+        }
+    }
+}
+
+template<ChartValue T>
+void decimateLttb(std::span<const T> values, size_t threshold, std::vector<size_t>& out) {
+    size_t count = values.size();
+    if (count <= threshold || threshold < 3) {
+        size_t first = out.size();
+        out.resize(first + count);
+        std::iota(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), size_t{0});
+        return;
+    }
+
+    out.reserve(out.size() + threshold);
+    // The first and last point are kept, the rest is split into equal buckets.
+    double bucketSize = static_cast<double>(count - 2) / static_cast<double>(threshold - 2);
+    size_t previous = 0;
+    out.push_back(0);
+
+    for (size_t bucket = 0; bucket < threshold - 2; ++bucket) {
+        size_t begin = static_cast<size_t>(std::floor(bucket * bucketSize)) + 1;
+        size_t end = static_cast<size_t>(std::floor((bucket + 1) * bucketSize)) + 1;
+
+        // Average of the next bucket, or the last point for the final bucket.
+        size_t nextBegin = end;
+        size_t nextEnd = std::min(static_cast<size_t>(std::floor((bucket + 2) * bucketSize)) + 1, count);
+        if (nextBegin >= nextEnd) {
+            nextBegin = count - 1;
+            nextEnd = count;
+        }
+        double averageX = 0.0, averageY = 0.0;
+        for (size_t i = nextBegin; i < nextEnd; ++i) {
+            averageX += static_cast<double>(i);
+            averageY += static_cast<double>(values[i]);
+        }
+        averageX /= static_cast<double>(nextEnd - nextBegin);
+        averageY /= static_cast<double>(nextEnd - nextBegin);
+
+        double previousX = static_cast<double>(previous);
+        double previousY = static_cast<double>(values[previous]);
+        size_t picked = begin;
+        double largestArea = -1.0;
+        for (size_t i = begin; i < end; ++i) {
+            // Twice the triangle's area, which orders the same.
+            double area = std::abs((previousX - averageX) * (static_cast<double>(values[i]) - previousY) -
+                                   (previousX - static_cast<double>(i)) * (averageY - previousY));
+            if (area > largestArea) {
+                largestArea = area;
+                picked = i;
+            }
+        }
+        out.push_back(picked);
+        previous = picked;
+    }
+
+    out.push_back(count - 1);
+}
+
+template void decimateMinMax<int32_t>(std::span<const int32_t>, size_t, std::vector<size_t>&);
+template void decimateMinMax<int64_t>(std::span<const int64_t>, size_t, std::vector<size_t>&);
+template void decimateMinMax<float>(std::span<const float>, size_t, std::vector<size_t>&);
+template void decimateMinMax<double>(std::span<const double>, size_t, std::vector<size_t>&);
+
+template void decimateLttb<int32_t>(std::span<const int32_t>, size_t, std::vector<size_t>&);
+template void decimateLttb<int64_t>(std::span<const int64_t>, size_t, std::vector<size_t>&);
+template void decimateLttb<float>(std::span<const float>, size_t, std::vector<size_t>&);
+template void decimateLttb<double>(std::span<const double>, size_t, std::vector<size_t>&);
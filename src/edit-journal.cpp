@@ -0,0 +1,254 @@
+#include "edit-journal.h"
+#include "file-io.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char journalMagic[8] = {'G', 'W', 'T', 'J', 'R', 'N', 'L', '1'};
+constexpr char snapshotMagic[8] = {'G', 'W', 'T', 'S', 'N', 'A', 'P', '1'};
+
+// type, sequence, offset, length
+constexpr size_t payloadHeaderSize = 1 + 8 + 8 + 8;
+constexpr size_t recordHeaderSize = 4 + 4;
+
+uint32_t crc32(const char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void put(std::vector<char>& out, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T get(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        contents.reserve(static_cast<size_t>(st.st_size));
+    }
+    char buffer[1 << 16];
+    for (;;) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        contents.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return true;
+}
+
+} // namespace
+
+bool applyEdit(std::string& document, const EditOp& op) {
+    if (op.offset > document.size()) return false;
+    if (op.type == EditType::Insert) {
+        document.insert(op.offset, op.text);
+        return true;
+    }
+    if (op.type == EditType::Erase && op.length <= document.size() - op.offset) {
+        document.erase(op.offset, op.length);
+        return true;
+    }
+    return false;
+}
+
+EditJournal::EditJournal(const std::string& path)
+        : journalPath(path + ".journal"), snapshotPath(path + ".snapshot") {
+    journalFd = ::open(journalPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (journalFd < 0) {
+        throw std::runtime_error("Can't open journal " + journalPath);
+    }
+}
+
+EditJournal::~EditJournal() {
+    if (journalFd >= 0) {
+        ::close(journalFd);
+    }
+}
+
+bool EditJournal::readSnapshot(Recovered& recovered) {
+    std::string contents;
+    if (!readFile(snapshotPath, contents)) return false;
+
+    constexpr size_t headerSize = sizeof(snapshotMagic) + 8 + 8 + 4;
+    if (contents.size() < headerSize ||
+        std::memcmp(contents.data(), snapshotMagic, sizeof(snapshotMagic)) != 0) {
+        std::cerr << "Ignoring unreadable snapshot " << snapshotPath << "\n";
+        return false;
+    }
+
+    const char* p = contents.data() + sizeof(snapshotMagic);
+    auto sequence = get<uint64_t>(p);
+    auto size = get<uint64_t>(p + 8);
+    auto crc = get<uint32_t>(p + 16);
+    if (contents.size() - headerSize != size || crc32(contents.data() + headerSize, size) != crc) {
+        std::cerr << "Ignoring corrupt snapshot " << snapshotPath << "\n";
+        return false;
+    }
+
+    recovered.document.assign(contents, headerSize, size);
+    recovered.sequence = sequence;
+    return true;
+}
+
+EditJournal::Recovered EditJournal::recover() {
+    Recovered recovered;
+    readSnapshot(recovered);
+
+    std::string contents;
+    readFile(journalPath, contents);
+
+    if (contents.size() < sizeof(journalMagic) ||
+        std::memcmp(contents.data(), journalMagic, sizeof(journalMagic)) != 0) {
+        resetJournal();
+        return recovered;
+    }
+
+    size_t pos = sizeof(journalMagic);
+    while (contents.size() - pos >= recordHeaderSize) {
+        auto size = get<uint32_t>(contents.data() + pos);
+        auto crc = get<uint32_t>(contents.data() + pos + 4);
+        const char* payload = contents.data() + pos + recordHeaderSize;
+        if (size < payloadHeaderSize || contents.size() - pos - recordHeaderSize < size ||
+            crc32(payload, size) != crc) {
+            break;
+        }
+
+        EditOp op;
+        op.type = static_cast<EditType>(payload[0]);
+        op.sequence = get<uint64_t>(payload + 1);
+        op.offset = get<uint64_t>(payload + 9);
+        op.length = get<uint64_t>(payload + 17);
+        if (op.type == EditType::Insert) {
+            op.text.assign(payload + payloadHeaderSize, size - payloadHeaderSize);
+        }
+
+        if (op.sequence > recovered.sequence) {
+            if (!applyEdit(recovered.document, op)) {
+                std::cerr << "Journal " << journalPath << " does not match its snapshot at edit "
+                          << op.sequence << ", dropping the rest\n";
+                break;
+            }
+            recovered.sequence = op.sequence;
+            recovered.replayedEdits++;
+        }
+        pos += recordHeaderSize + size;
+    }
+
+    if (pos != contents.size()) {
+        std::cerr << "Truncating " << contents.size() - pos << " bytes of torn journal tail\n";
+        if (::ftruncate(journalFd, static_cast<off_t>(pos)) != 0) {
+            std::cerr << "Failed to truncate " << journalPath << ": " << std::strerror(errno) << "\n";
+        }
+    }
+    ::lseek(journalFd, static_cast<off_t>(pos), SEEK_SET);
+    journalBytes = pos;
+    return recovered;
+}
+
+void EditJournal::append(const std::vector<EditOp>& ops) {
+    encodeBuffer.clear();
+    for (const EditOp& op : ops) {
+        size_t textSize = op.type == EditType::Insert ? op.text.size() : 0;
+        auto size = static_cast<uint32_t>(payloadHeaderSize + textSize);
+
+        size_t recordStart = encodeBuffer.size();
+        put<uint32_t>(encodeBuffer, size);
+        put<uint32_t>(encodeBuffer, 0);
+        encodeBuffer.push_back(static_cast<char>(op.type));
+        put<uint64_t>(encodeBuffer, op.sequence);
+        put<uint64_t>(encodeBuffer, op.offset);
+        put<uint64_t>(encodeBuffer, op.length);
+        encodeBuffer.insert(encodeBuffer.end(), op.text.begin(), op.text.begin() + textSize);
+
+        uint32_t crc = crc32(encodeBuffer.data() + recordStart + recordHeaderSize, size);
+        std::memcpy(encodeBuffer.data() + recordStart + 4, &crc, sizeof(crc));
+    }
+
+    if (!writeAll(journalFd, encodeBuffer.data(), encodeBuffer.size())) {
+        std::cerr << "Failed to append to " << journalPath << ": " << std::strerror(errno) << "\n";
+        return;
+    }
+    journalBytes += encodeBuffer.size();
+}
+
+bool EditJournal::isEmpty() const {
+    return journalBytes <= sizeof(journalMagic);
+}
+
+void EditJournal::sync() {
+    ::fdatasync(journalFd);
+}
+
+void EditJournal::compact(const std::string& document, uint64_t sequence) {
+    std::string tmpPath = snapshotPath + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << tmpPath << ": " << std::strerror(errno) << "\n";
+        return;
+    }
+
+    std::vector<char> header(snapshotMagic, snapshotMagic + sizeof(snapshotMagic));
+    put<uint64_t>(header, sequence);
+    put<uint64_t>(header, document.size());
+    put<uint32_t>(header, crc32(document.data(), document.size()));
+
+    bool ok = writeAll(fd, header.data(), header.size()) &&
+              writeAll(fd, document.data(), document.size()) &&
+              ::fdatasync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) {
+        std::cerr << "Failed to write snapshot " << snapshotPath << ": " << std::strerror(errno) << "\n";
+        ::unlink(tmpPath.c_str());
+        return;
+    }
+    syncParentDirectory(snapshotPath);
+
+    // Only drop the journal once the snapshot covering it is durable.
+    resetJournal();
+}
+
+void EditJournal::resetJournal() {
+    if (::ftruncate(journalFd, 0) != 0 || ::lseek(journalFd, 0, SEEK_SET) != 0 ||
+        !writeAll(journalFd, journalMagic, sizeof(journalMagic))) {
+        std::cerr << "Failed to reset " << journalPath << ": " << std::strerror(errno) << "\n";
+        return;
+    }
+    ::fdatasync(journalFd);
+    journalBytes = sizeof(journalMagic);
+}
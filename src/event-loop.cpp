@@ -0,0 +1,276 @@
+#include "event-loop.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+const struct wl_callback_listener EventLoop::frame_listener = {
+        .done = EventLoop::frameDoneHandler,
+};
+
+EventLoop::EventLoop(struct wl_display* display) : display(display) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        close(epollFd);
+        throw std::runtime_error("Failed to create eventfd");
+    }
+
+    watch(wl_display_get_fd(display), EPOLLIN, EPOLL_CTL_ADD);
+    watch(wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+}
+
+EventLoop::~EventLoop() {
+    if (frame) {
+        wl_callback_destroy(frame);
+    }
+    for (int timer : timers) {
+        close(timer);
+    }
+    if (signalFd >= 0) {
+        close(signalFd);
+    }
+    close(wakeFd);
+    close(epollFd);
+}
+
+void EventLoop::watch(int fd, uint32_t events, int operation) {
+    struct epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, operation, fd, &event) != 0) {
+        throw std::runtime_error(std::string("Failed to watch fd: ") + strerror(errno));
+    }
+}
+
+void EventLoop::run() {
+    const int displayFd = wl_display_get_fd(display);
+    struct epoll_event events[32];
+    running = true;
+
+    while (running) {
+        while (wl_display_prepare_read(display) != 0) {
+            if (wl_display_dispatch_pending(display) == -1) return;
+        }
+        flushDisplay();
+
+        // With idle work queued the loop only peeks, so the work runs as
+        // soon as nothing else is ready.
+        bool hasIdleWork = !idleCallbacks.empty() && !isFramePending();
+        int count = epoll_wait(epollFd, events, 32, hasIdleWork ? 0 : -1);
+        if (count < 0) {
+            wl_display_cancel_read(display);
+            if (errno == EINTR) continue;
+            std::cerr << "epoll_wait failed: " << strerror(errno) << "\n";
+            return;
+        }
+
+        bool displayReadable = false;
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd != displayFd) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                wl_display_cancel_read(display);
+                std::cerr << "Lost the connection to the Wayland display.\n";
+                return;
+            }
+            displayReadable = events[i].events & EPOLLIN;
+            if (events[i].events & EPOLLOUT) {
+                flushDisplay();
+            }
+        }
+        if (displayReadable) {
+            if (wl_display_read_events(display) == -1) return;
+        } else {
+            wl_display_cancel_read(display);
+        }
+        if (wl_display_dispatch_pending(display) == -1) return;
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == displayFd) continue;
+            if (fd == wakeFd) {
+                runPosted();
+            } else if (fd == signalFd) {
+                runSignals();
+            } else {
+                // An earlier callback may have removed the watcher already.
+                auto it = watchers.find(fd);
+                if (it == watchers.end()) continue;
+                std::shared_ptr<Watcher> watcher = it->second;
+                watcher->callback(events[i].events);
+            }
+        }
+
+        if (count == 0) {
+            runIdle();
+        }
+    }
+}
+
+void EventLoop::quit() {
+    post([this] { running = false; });
+}
+
+void EventLoop::flushDisplay() {
+    bool blocked = wl_display_flush(display) < 0 && errno == EAGAIN;
+    if (blocked != flushPending) {
+        // Wait for the socket to drain instead of dropping requests.
+        flushPending = blocked;
+        watch(wl_display_get_fd(display), blocked ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+    }
+}
+
+void EventLoop::addFd(int fd, uint32_t events, FdCallback callback) {
+    watch(fd, events, EPOLL_CTL_ADD);
+    watchers[fd] = std::make_shared<Watcher>(Watcher{fd, std::move(callback)});
+}
+
+void EventLoop::removeFd(int fd) {
+    if (watchers.erase(fd) > 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval, Callback callback) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create timerfd");
+    }
+
+    auto toTimespec = [](std::chrono::milliseconds duration) {
+        return timespec{static_cast<time_t>(duration.count() / 1000),
+                        static_cast<long>(duration.count() % 1000 * 1000000)};
+    };
+    struct itimerspec spec{};
+    spec.it_interval = toTimespec(interval);
+    // A zero it_value would disarm the timer.
+    spec.it_value = toTimespec(std::max(delay, std::chrono::milliseconds(0)));
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(fd, 0, &spec, nullptr);
+
+    bool repeating = interval.count() > 0;
+    timers.insert(fd);
+    addFd(fd, EPOLLIN, [this, fd, repeating, callback = std::move(callback)](uint32_t) {
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+        if (!repeating) {
+            // Keep the callback alive until it returns.
+            Callback fire = callback;
+            cancelTimer(fd);
+            fire();
+            return;
+        }
+        callback();
+    });
+    return fd;
+}
+
+void EventLoop::cancelTimer(int id) {
+    if (timers.erase(id) == 0) return;
+    removeFd(id);
+    close(id);
+}
+
+void EventLoop::addSignal(int signal, SignalCallback callback) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (auto& [number, handler] : signalCallbacks) {
+        sigaddset(&mask, number);
+    }
+    sigaddset(&mask, signal);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    bool first = signalFd < 0;
+    signalFd = signalfd(signalFd, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (signalFd < 0) {
+        throw std::runtime_error("Failed to create signalfd");
+    }
+    if (first) {
+        watch(signalFd, EPOLLIN, EPOLL_CTL_ADD);
+    }
+    signalCallbacks[signal] = std::move(callback);
+}
+
+void EventLoop::runSignals() {
+    struct signalfd_siginfo info;
+    while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+        auto it = signalCallbacks.find(static_cast<int>(info.ssi_signo));
+        if (it != signalCallbacks.end()) {
+            it->second(static_cast<int>(info.ssi_signo));
+        }
+    }
+}
+
+void EventLoop::post(Callback task) {
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        posted.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        std::cerr << "Failed to wake the event loop: " << strerror(errno) << "\n";
+    }
+}
+
+void EventLoop::runPosted() {
+    uint64_t wakeups;
+    while (read(wakeFd, &wakeups, sizeof(wakeups)) > 0) {
+    }
+
+    std::vector<Callback> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        tasks.swap(posted);
+    }
+    for (Callback& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::idle(Callback callback) {
+    idleCallbacks.push_back(std::move(callback));
+}
+
+void EventLoop::runIdle() {
+    if (isFramePending()) return;
+    // Work queued by these callbacks waits for the next idle round.
+    std::vector<Callback> callbacks;
+    callbacks.swap(idleCallbacks);
+    for (Callback& callback : callbacks) {
+        callback();
+    }
+}
+
+void EventLoop::requestFrame(struct wl_surface* surface, Callback callback) {
+    if (callback) {
+        frameCallbacks.push_back(std::move(callback));
+    }
+    if (frame) return;
+    frame = wl_surface_frame(surface);
+    wl_callback_add_listener(frame, &frame_listener, this);
+}
+
+void EventLoop::frameDoneHandler(void* data, struct wl_callback* callback, uint32_t time) {
+    auto* self = static_cast<EventLoop*>(data);
+    wl_callback_destroy(callback);
+    self->frame = nullptr;
+
+    std::vector<Callback> callbacks;
+    callbacks.swap(self->frameCallbacks);
+    for (Callback& frameCallback : callbacks) {
+        frameCallback();
+    }
+}
@@ -0,0 +1,121 @@
+#include "heatmap-raster.h"
+#include "chart-kernels.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Output rows per parallelFor chunk.
+constexpr size_t rowGrain = 8;
+
+struct ColorStop {
+    double position;
+    double r, g, b;
+};
+
+std::array<uint32_t, 256> interpolate(std::initializer_list<ColorStop> stops) {
+    std::array<uint32_t, 256> table{};
+    auto stop = stops.begin();
+    for (size_t i = 0; i < table.size(); ++i) {
+        double position = static_cast<double>(i) / (table.size() - 1);
+        while (stop + 2 != stops.end() && position > (stop + 1)->position) ++stop;
+        const ColorStop& from = stop[0];
+        const ColorStop& to = stop[1];
+        double t = std::clamp((position - from.position) / (to.position - from.position), 0.0, 1.0);
+        auto channel = [t](double a, double b) {
+            return static_cast<uint32_t>((a + (b - a) * t) * 255.0 + 0.5);
+        };
+        table[i] = 0xff000000u | channel(from.r, to.r) << 16 | channel(from.g, to.g) << 8 | channel(from.b, to.b);
+    }
+    return table;
+}
+
+// [first, last) of the cells under pixel index of pixels, never empty.
+std::pair<size_t, size_t> cellsUnder(size_t index, size_t pixels, size_t cells) {
+    size_t first = index * cells / pixels;
+    size_t last = std::max((index + 1) * cells / pixels, first + 1);
+    return {first, last};
+}
+
+}
+
+const std::array<uint32_t, 256>& colormapTable(Colormap colormap) {
+    // Few stops of the matplotlib maps; linear between them is close enough on screen.
+    static const std::array<uint32_t, 256> viridis = interpolate({
+            {0.00, 0.267, 0.005, 0.329},
+            {0.25, 0.229, 0.322, 0.546},
+            {0.50, 0.128, 0.567, 0.551},
+            {0.75, 0.369, 0.789, 0.383},
+            {1.00, 0.993, 0.906, 0.144},
+    });
+    static const std::array<uint32_t, 256> inferno = interpolate({
+            {0.00, 0.001, 0.000, 0.014},
+            {0.25, 0.341, 0.062, 0.429},
+            {0.50, 0.735, 0.216, 0.330},
+            {0.75, 0.978, 0.557, 0.035},
+            {1.00, 0.988, 0.998, 0.645},
+    });
+    static const std::array<uint32_t, 256> grayscale = interpolate({
+            {0.0, 0.0, 0.0, 0.0},
+            {1.0, 1.0, 1.0, 1.0},
+    });
+    switch (colormap) {
+        case Colormap::Inferno:
+            return inferno;
+        case Colormap::Grayscale:
+            return grayscale;
+        case Colormap::Viridis:
+        default:
+            return viridis;
+    }
+}
+
+template<ChartValue T>
+void renderHeatmap(std::span<const T> values, size_t rows, size_t cols, double low, double high,
+                   Colormap colormap, unsigned char* pixels, int width, int height, int stride, ThreadPool& pool) {
+    if (rows == 0 || cols == 0 || values.size() < rows * cols || width <= 0 || height <= 0) return;
+
+    const std::array<uint32_t, 256>& table = colormapTable(colormap);
+    double scale = high > low ? 255.0 / (high - low) : 0.0;
+    double offset = high > low ? -low * scale : 127.0;
+
+    pool.parallelFor(static_cast<size_t>(height), rowGrain, [&](size_t begin, size_t end) {
+        std::vector<double> means(static_cast<size_t>(width));
+        std::vector<float> indices(static_cast<size_t>(width));
+        for (size_t y = begin; y < end; ++y) {
+            auto [first_row, last_row] = cellsUnder(y, static_cast<size_t>(height), rows);
+            std::fill(means.begin(), means.end(), 0.0);
+            for (size_t row = first_row; row < last_row; ++row) {
+                std::span<const T> cells = values.subspan(row * cols, cols);
+                for (size_t x = 0; x < means.size(); ++x) {
+                    auto [first_col, last_col] = cellsUnder(x, means.size(), cols);
+                    if (last_col - first_col == 1) {
+                        means[x] += static_cast<double>(cells[first_col]);
+                    } else {
+                        means[x] += sumOf(cells.subspan(first_col, last_col - first_col)) /
+                                    static_cast<double>(last_col - first_col);
+                    }
+                }
+            }
+
+            // Means onto [0, 255] in one kernel call, then through the table.
+            affineTransform(std::span<const double>(means), scale / static_cast<double>(last_row - first_row),
+                            offset, std::span<float>(indices));
+            auto* out = reinterpret_cast<uint32_t*>(pixels + y * stride);
+            for (size_t x = 0; x < indices.size(); ++x) {
+                // NaN fails the first test and takes the low end.
+                float index = indices[x];
+                out[x] = table[index >= 0.0f ? static_cast<size_t>(std::min(index, 255.0f)) : 0];
+            }
+        }
+    });
+}
+
+template void renderHeatmap<int32_t>(std::span<const int32_t>, size_t, size_t, double, double, Colormap,
+                                     unsigned char*, int, int, int, ThreadPool&);
+template void renderHeatmap<int64_t>(std::span<const int64_t>, size_t, size_t, double, double, Colormap,
+                                     unsigned char*, int, int, int, ThreadPool&);
+template void renderHeatmap<float>(std::span<const float>, size_t, size_t, double, double, Colormap,
+                                   unsigned char*, int, int, int, ThreadPool&);
+template void renderHeatmap<double>(std::span<const double>, size_t, size_t, double, double, Colormap,
+                                    unsigned char*, int, int, int, ThreadPool&);
@@ -0,0 +1,114 @@
+#include "hit-grid.h"
+
+HitGrid::HitGrid(int cellSize) : cellSize(cellSize) {
+}
+
+int HitGrid::cellOf(int coordinate) const {
+    // Rounds down for negative coordinates too.
+    return coordinate >= 0 ? coordinate / cellSize : -((-coordinate + cellSize - 1) / cellSize);
+}
+
+HitGrid::CellRange HitGrid::rangeOf(const Rect& bounds) const {
+    // Edges are inclusive, like Rect::contains.
+    return {cellOf(bounds.x), cellOf(bounds.y), cellOf(bounds.x + bounds.width), cellOf(bounds.y + bounds.height)};
+}
+
+uint64_t HitGrid::key(int cx, int cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+bool HitGrid::above(WidgetId a, WidgetId b) const {
+    const Item& first = items[a];
+    const Item& second = items[b];
+    return first.z != second.z ? first.z > second.z : first.order > second.order;
+}
+
+void HitGrid::addToCell(int cx, int cy, WidgetId id) {
+    std::vector<WidgetId>& cell = cells[key(cx, cy)];
+    auto it = std::lower_bound(cell.begin(), cell.end(), id, [this](WidgetId a, WidgetId b) { return above(a, b); });
+    cell.insert(it, id);
+}
+
+void HitGrid::removeFromCell(int cx, int cy, WidgetId id) {
+    auto it = cells.find(key(cx, cy));
+    if (it == cells.end()) return;
+    std::erase(it->second, id);
+    if (it->second.empty()) {
+        cells.erase(it);
+    }
+}
+
+void HitGrid::insert(WidgetId id, const Rect& bounds, int z) {
+    if (id >= items.size()) {
+        items.resize(id + 1);
+    }
+    remove(id);
+    items[id] = {bounds, z, nextOrder++, true};
+
+    CellRange range = rangeOf(bounds);
+    for (int cy = range.y0; cy <= range.y1; ++cy) {
+        for (int cx = range.x0; cx <= range.x1; ++cx) {
+            addToCell(cx, cy, id);
+        }
+    }
+}
+
+void HitGrid::move(WidgetId id, const Rect& bounds) {
+    if (id >= items.size() || !items[id].alive) return;
+    Item& item = items[id];
+    CellRange before = rangeOf(item.bounds);
+    CellRange after = rangeOf(bounds);
+    item.bounds = bounds;
+
+    for (int cy = before.y0; cy <= before.y1; ++cy) {
+        for (int cx = before.x0; cx <= before.x1; ++cx) {
+            if (!after.contains(cx, cy)) removeFromCell(cx, cy, id);
+        }
+    }
+    for (int cy = after.y0; cy <= after.y1; ++cy) {
+        for (int cx = after.x0; cx <= after.x1; ++cx) {
+            if (!before.contains(cx, cy)) addToCell(cx, cy, id);
+        }
+    }
+}
+
+void HitGrid::remove(WidgetId id) {
+    if (id >= items.size() || !items[id].alive) return;
+    Item& item = items[id];
+    CellRange range = rangeOf(item.bounds);
+    for (int cy = range.y0; cy <= range.y1; ++cy) {
+        for (int cx = range.x0; cx <= range.x1; ++cx) {
+            removeFromCell(cx, cy, id);
+        }
+    }
+    item.alive = false;
+}
+
+std::optional<WidgetId> HitGrid::hitTest(int x, int y) const {
+    auto it = cells.find(key(cellOf(x), cellOf(y)));
+    if (it == cells.end()) return std::nullopt;
+    for (WidgetId id : it->second) {
+        if (items[id].bounds.contains(x, y)) return id;
+    }
+    return std::nullopt;
+}
+
+void HitGrid::query(const Rect& area, std::vector<WidgetId>& out) const {
+    size_t first = out.size();
+    CellRange range = rangeOf(area);
+    for (int cy = range.y0; cy <= range.y1; ++cy) {
+        for (int cx = range.x0; cx <= range.x1; ++cx) {
+            auto it = cells.find(key(cx, cy));
+            if (it == cells.end()) continue;
+            for (WidgetId id : it->second) {
+                if (items[id].bounds.intersects(area)) out.push_back(id);
+            }
+        }
+    }
+
+    // Widgets spanning several cells were found more than once.
+    auto begin = out.begin() + static_cast<std::ptrdiff_t>(first);
+    std::sort(begin, out.end());
+    out.erase(std::unique(begin, out.end()), out.end());
+    std::sort(begin, out.end(), [this](WidgetId a, WidgetId b) { return above(a, b); });
+}
@@ -0,0 +1,91 @@
+#include "hover-index.h"
+#include <algorithm>
+
+namespace {
+
+// Ranges this short are scanned rather than split further.
+constexpr size_t leafSize = 8;
+
+float coordinate(const HoverPoint& point, bool byX) {
+    return byX ? point.x : point.y;
+}
+
+}
+
+void HoverIndex::clear() {
+    points.clear();
+    built = false;
+}
+
+void HoverIndex::add(const HoverPoint& point) {
+    points.push_back(point);
+    built = false;
+}
+
+const HoverPoint* HoverIndex::nearest(float x, float y, float radius) {
+    if (!built) {
+        build(0, points.size(), true);
+        built = true;
+    }
+    float bestDistance = radius * radius;
+    const HoverPoint* best = nullptr;
+    search(0, points.size(), true, x, y, bestDistance, best);
+    return best;
+}
+
+void HoverIndex::build(size_t first, size_t last, bool byX) {
+    // Iterates down the larger half, so the stack stays logarithmic.
+    while (last - first > leafSize) {
+        size_t middle = first + (last - first) / 2;
+        std::nth_element(points.begin() + first, points.begin() + middle, points.begin() + last,
+                         [byX](const HoverPoint& a, const HoverPoint& b) {
+            return coordinate(a, byX) < coordinate(b, byX);
+        });
+        build(first, middle, !byX);
+        first = middle + 1;
+        byX = !byX;
+    }
+}
+
+void HoverIndex::search(size_t first, size_t last, bool byX, float x, float y, float& bestDistance,
+                        const HoverPoint*& best) const {
+    if (last - first <= leafSize) {
+        for (size_t i = first; i < last; ++i) {
+            float dx = points[i].x - x;
+            float dy = points[i].y - y;
+            float distance = dx * dx + dy * dy;
+            if (distance <= bestDistance) {
+                bestDistance = distance;
+                best = &points[i];
+            }
+        }
+        return;
+    }
+
+    size_t middle = first + (last - first) / 2;
+    const HoverPoint& median = points[middle];
+    float dx = median.x - x;
+    float dy = median.y - y;
+    float distance = dx * dx + dy * dy;
+    if (distance <= bestDistance) {
+        bestDistance = distance;
+        best = &median;
+    }
+
+    // The side holding the pointer first; the other only while the
+    // splitting line is closer than the best point so far.
+    float offset = (byX ? x : y) - coordinate(median, byX);
+    bool before = offset < 0.0f;
+    if (before) {
+        search(first, middle, !byX, x, y, bestDistance, best);
+    } else {
+        search(middle + 1, last, !byX, x, y, bestDistance, best);
+    }
+    if (offset * offset <= bestDistance) {
+        if (before) {
+            search(middle + 1, last, !byX, x, y, bestDistance, best);
+        } else {
+            search(first, middle, !byX, x, y, bestDistance, best);
+        }
+    }
+}
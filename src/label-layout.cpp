@@ -0,0 +1,150 @@
+#include "label-layout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Spatial hash cells: about a short label wide, and never more than
+// maxCells to a side however far apart the labels are.
+constexpr double cellSize = 32.0;
+constexpr size_t maxCells = 256;
+
+}
+
+double niceStep(double span, size_t maxSteps) {
+    if (!(span > 0.0) || !std::isfinite(span)) return 0.0;
+    double raw = span / static_cast<double>(std::max<size_t>(maxSteps, 1));
+    double magnitude = std::pow(10.0, std::floor(std::log10(raw)));
+    for (double factor : {1.0, 2.0, 5.0}) {
+        // Slack for log10 landing just below a power of ten.
+        if (factor * magnitude >= raw * (1.0 - 1e-12)) return factor * magnitude;
+    }
+    return 10.0 * magnitude;
+}
+
+std::vector<double> niceTicks(double low, double high, size_t maxSteps) {
+    std::vector<double> ticks;
+    double step = niceStep(high - low, maxSteps);
+    if (step == 0.0) {
+        if (std::isfinite(low)) ticks.push_back(low);
+        return ticks;
+    }
+    double first = std::ceil(low / step - 1e-9);
+    double last = std::floor(high / step + 1e-9);
+    for (double k = first; k <= last; ++k) {
+        // Multiplied out rather than summed, so steps do not drift.
+        ticks.push_back(k == 0.0 ? 0.0 : k * step);
+    }
+    return ticks;
+}
+
+bool PlacedLabel::overlaps(const PlacedLabel& other, double gap) const {
+    return left < other.left + other.width + gap && other.left < left + width + gap &&
+           top < other.top + other.height + gap && other.top < top + height + gap;
+}
+
+void cullOverlapping(std::vector<PlacedLabel>& labels, double gap) {
+    if (labels.size() < 2) return;
+
+    double min_x = labels[0].left, max_x = labels[0].left + labels[0].width;
+    double min_y = labels[0].top, max_y = labels[0].top + labels[0].height;
+    for (const PlacedLabel& label : labels) {
+        min_x = std::min(min_x, label.left);
+        max_x = std::max(max_x, label.left + label.width);
+        min_y = std::min(min_y, label.top);
+        max_y = std::max(max_y, label.top + label.height);
+    }
+    double cell_width = std::max(cellSize, (max_x - min_x) / maxCells);
+    double cell_height = std::max(cellSize, (max_y - min_y) / maxCells);
+    auto columns = static_cast<size_t>((max_x - min_x) / cell_width) + 1;
+    auto rows = static_cast<size_t>((max_y - min_y) / cell_height) + 1;
+    auto column = [&](double at) {
+        return static_cast<size_t>(std::clamp((at - min_x) / cell_width, 0.0, static_cast<double>(columns - 1)));
+    };
+    auto row = [&](double at) {
+        return static_cast<size_t>(std::clamp((at - min_y) / cell_height, 0.0, static_cast<double>(rows - 1)));
+    };
+
+    // Kept labels by the cells their boxes cover; a label is tested against
+    // those in the cells its box covers grown by gap.
+    std::vector<std::vector<uint32_t>> cells(columns * rows);
+    size_t kept = 0;
+    for (size_t i = 0; i < labels.size(); ++i) {
+        const PlacedLabel& label = labels[i];
+        bool clear = true;
+        size_t last_row = row(label.top + label.height + gap);
+        size_t last_column = column(label.left + label.width + gap);
+        for (size_t r = row(label.top - gap); clear && r <= last_row; ++r) {
+            for (size_t c = column(label.left - gap); clear && c <= last_column; ++c) {
+                for (uint32_t other : cells[r * columns + c]) {
+                    if (labels[other].overlaps(label, gap)) {
+                        clear = false;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!clear) continue;
+
+        if (kept != i) labels[kept] = std::move(labels[i]);
+        const PlacedLabel& placed = labels[kept];
+        for (size_t r = row(placed.top); r <= row(placed.top + placed.height); ++r) {
+            for (size_t c = column(placed.left); c <= column(placed.left + placed.width); ++c) {
+                cells[r * columns + c].push_back(static_cast<uint32_t>(kept));
+            }
+        }
+        ++kept;
+    }
+    labels.resize(kept);
+}
+
+TextExtentsCache::~TextExtentsCache() {
+    if (scratch) {
+        cairo_destroy(scratch);
+    }
+}
+
+const cairo_text_extents_t& TextExtentsCache::measure(const std::string& text) {
+    auto it = extents.find(text);
+    if (it != extents.end()) return it->second;
+
+    if (!scratch) {
+        cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+        scratch = cairo_create(surface);
+        cairo_surface_destroy(surface);
+        cairo_select_font_face(scratch, family.c_str(), CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(scratch, size);
+    }
+    if (extents.size() >= capacity) extents.clear();
+
+    cairo_text_extents_t measured;
+    cairo_text_extents(scratch, text.c_str(), &measured);
+    return extents.emplace(text, measured).first->second;
+}
+
+PlacedLabel TextExtentsCache::place(std::string text, double x, double y, LabelAnchor anchor) {
+    const cairo_text_extents_t& measured = measure(text);
+    PlacedLabel label;
+    switch (anchor) {
+        case LabelAnchor::Right:
+            label.x = x - measured.width;
+            label.y = y + measured.height / 2.0;
+            break;
+        case LabelAnchor::Center:
+            label.x = x - measured.width / 2.0;
+            label.y = y + measured.height / 2.0;
+            break;
+        case LabelAnchor::Baseline:
+        default:
+            label.x = x - measured.width / 2.0;
+            label.y = y;
+            break;
+    }
+    label.left = label.x + measured.x_bearing;
+    label.top = label.y + measured.y_bearing;
+    label.width = measured.width;
+    label.height = measured.height;
+    label.text = std::move(text);
+    return label;
+}
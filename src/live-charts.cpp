@@ -0,0 +1,60 @@
+#include "live-charts.h"
+#include "application.h"
+#include <sys/epoll.h>
+#include <unistd.h>
+
+LiveCharts::LiveCharts(EventLoop& loop, CairoRenderer& renderer, struct wl_surface* surface)
+        : loop(loop), renderer(renderer), surface(surface) {
+}
+
+LiveCharts::~LiveCharts() {
+    for (const Subscription& subscription : subscriptions) {
+        loop.removeFd(subscription.fd);
+    }
+}
+
+void LiveCharts::add(int fd, std::function<size_t()> drain, std::function<void()> draw) {
+    subscriptions.push_back({fd, std::move(drain), std::move(draw)});
+    loop.addFd(fd, EPOLLIN, [this, fd](uint32_t) { onReadable(fd); });
+}
+
+void LiveCharts::remove(int fd) {
+    loop.removeFd(fd);
+    std::erase_if(subscriptions, [fd](const Subscription& subscription) { return subscription.fd == fd; });
+}
+
+void LiveCharts::onReadable(int fd) {
+    uint64_t count;
+    [[maybe_unused]] ssize_t bytes = read(fd, &count, sizeof(count));
+
+    for (Subscription& subscription : subscriptions) {
+        if (subscription.fd == fd) subscription.dirty = true;
+    }
+    if (scheduled) return;
+    scheduled = true;
+    if (loop.isFramePending()) {
+        loop.requestFrame(surface, [this] { redraw(); });
+    } else {
+        redraw();
+    }
+}
+
+void LiveCharts::redraw() {
+    scheduled = false;
+
+    std::vector<Subscription*> changed;
+    for (Subscription& subscription : subscriptions) {
+        if (!subscription.dirty) continue;
+        subscription.dirty = false;
+        if (subscription.drain() > 0) changed.push_back(&subscription);
+    }
+    // A frame request is only made when a commit follows.
+    if (changed.empty()) return;
+
+    loop.requestFrame(surface);
+    renderer.beginBatch();
+    for (Subscription* subscription : changed) {
+        subscription->draw();
+    }
+    renderer.endBatch();
+}
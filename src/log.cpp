@@ -0,0 +1,316 @@
+#include "log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct RecordHeader {
+    uint32_t size; // including the header and the alignment padding
+    uint8_t level;
+    uint8_t argCount;
+    int64_t time;
+    const char* format;
+};
+
+// Fills the rest of the ring so that a record never wraps around. Records are
+// 8-byte aligned, so at least size and level of a padding header always fit.
+constexpr uint8_t paddingLevel = 0xFF;
+constexpr size_t ringCapacity = 1 << 18;
+
+size_t aligned(size_t size) {
+    return (size + 7) & ~size_t{7};
+}
+
+// Single producer (the owning thread), single consumer (the writer thread).
+// head and tail only grow, their difference is the used space.
+struct Ring {
+    std::unique_ptr<std::byte[]> data{new std::byte[ringCapacity]};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};
+    // Producer side state between reserve() and commit().
+    uint64_t reservedEnd = 0;
+
+    const RecordHeader& peek() const {
+        return *reinterpret_cast<const RecordHeader*>(&data[tail.load(std::memory_order_relaxed) % ringCapacity]);
+    }
+    bool empty() const {
+        return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+};
+
+class Logger {
+public:
+    Logger() : start(Clock::now()), writer(&Logger::writerLoop, this) {
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_one();
+        writer.join();
+    }
+
+    std::shared_ptr<Ring> registerRing() {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(mutex);
+        rings.push_back(ring);
+        return ring;
+    }
+
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    }
+
+    // Called by producers after publishing a record.
+    void notify() {
+        if (sleeping.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeUp.notify_one();
+        }
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t target = ++flushRequests;
+        wakeUp.notify_one();
+        flushed.wait(lock, [this, target] { return flushesDone >= target || stopping; });
+    }
+
+private:
+    const Clock::time_point start;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable flushed;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::atomic<bool> sleeping{false};
+    bool stopping = false;
+    uint64_t flushRequests = 0;
+    uint64_t flushesDone = 0;
+    std::string out;
+    std::thread writer;
+
+    void writerLoop() {
+        // Signals belong to the event loop thread.
+        sigset_t signals;
+        sigfillset(&signals);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        for (;;) {
+            uint64_t flushTarget;
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                sleeping.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!stopping && flushRequests == flushesDone && !hasPending(rings)) {
+                    wakeUp.wait_for(lock, std::chrono::milliseconds(100));
+                }
+                sleeping.store(false);
+                snapshot = rings;
+                flushTarget = flushRequests;
+                stop = stopping;
+            }
+
+            drain(snapshot);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                // Rings of finished threads go away once they are empty.
+                std::erase_if(rings, [](const std::shared_ptr<Ring>& ring) {
+                    return ring->retired.load() && ring->empty();
+                });
+                flushesDone = flushTarget;
+            }
+            flushed.notify_all();
+            if (stop) return;
+        }
+    }
+
+    static bool hasPending(const std::vector<std::shared_ptr<Ring>>& rings) {
+        for (const auto& ring : rings) {
+            if (!ring->empty()) return true;
+        }
+        return false;
+    }
+
+    // Emits the records of all rings in time order.
+    void drain(const std::vector<std::shared_ptr<Ring>>& snapshot) {
+        for (;;) {
+            Ring* next = nullptr;
+            for (const auto& ring : snapshot) {
+                skipPadding(*ring);
+                if (!ring->empty() && (!next || ring->peek().time < next->peek().time)) {
+                    next = ring.get();
+                }
+            }
+            if (!next) break;
+
+            const RecordHeader& header = next->peek();
+            format(header, reinterpret_cast<const std::byte*>(&header + 1));
+            next->tail.store(next->tail.load(std::memory_order_relaxed) + header.size, std::memory_order_release);
+        }
+
+        for (const auto& ring : snapshot) {
+            uint64_t dropped = ring->dropped.exchange(0);
+            if (dropped > 0) {
+                out += "[warning] " + std::to_string(dropped) + " log records dropped\n";
+            }
+        }
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            out.clear();
+        }
+    }
+
+    static void skipPadding(Ring& ring) {
+        while (!ring.empty() && ring.peek().level == paddingLevel) {
+            ring.tail.store(ring.tail.load(std::memory_order_relaxed) + ring.peek().size, std::memory_order_release);
+        }
+    }
+
+    void format(const RecordHeader& header, const std::byte* args) {
+        static const char* const names[] = {"debug", "info", "warning", "error"};
+        char prefix[48];
+        std::snprintf(prefix, sizeof(prefix), "[%8.3f %s] ", header.time / 1e6, names[header.level & 3]);
+        out += prefix;
+
+        uint8_t remaining = header.argCount;
+        for (const char* p = header.format; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}' && remaining > 0) {
+                args = appendArg(args);
+                remaining--;
+                ++p;
+            } else {
+                out += *p;
+            }
+        }
+        out += '\n';
+    }
+
+    const std::byte* appendArg(const std::byte* in) {
+        auto type = static_cast<ArgType>(*in++);
+        auto read = [&in](void* value, size_t size) {
+            std::memcpy(value, in, size);
+            in += size;
+        };
+        switch (type) {
+            case ArgType::Int: {
+                int64_t value;
+                read(&value, 8);
+                out += std::to_string(value);
+                break;
+            }
+            case ArgType::Unsigned: {
+                uint64_t value;
+                read(&value, 8);
+                out += std::to_string(value);
+                break;
+            }
+            case ArgType::Double: {
+                double value;
+                read(&value, 8);
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%g", value);
+                out += buffer;
+                break;
+            }
+            case ArgType::Bool: {
+                uint8_t value;
+                read(&value, 1);
+                out += value ? "true" : "false";
+                break;
+            }
+            case ArgType::String: {
+                uint32_t length;
+                read(&length, sizeof(length));
+                out.append(reinterpret_cast<const char*>(in), length);
+                in += length;
+                break;
+            }
+        }
+        return in;
+    }
+};
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+// Marks the ring retired when its thread exits, the writer still drains it.
+struct ThreadRing {
+    std::shared_ptr<Ring> ring = logger().registerRing();
+
+    ~ThreadRing() {
+        ring->retired.store(true);
+    }
+};
+
+Ring& threadRing() {
+    thread_local ThreadRing local;
+    return *local.ring;
+}
+
+} // namespace
+
+std::byte* reserve(Level level, const char* format, uint8_t argCount, size_t size) {
+    Ring& ring = threadRing();
+    size_t needed = aligned(sizeof(RecordHeader) + size);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    size_t offset = head % ringCapacity;
+    size_t toEnd = ringCapacity - offset;
+    size_t total = needed > toEnd ? toEnd + needed : needed;
+    if (needed > ringCapacity || total > ringCapacity - (head - tail)) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (needed > toEnd) {
+        auto* padding = reinterpret_cast<RecordHeader*>(&ring.data[offset]);
+        padding->size = static_cast<uint32_t>(toEnd);
+        padding->level = paddingLevel;
+        head += toEnd;
+        offset = 0;
+    }
+
+    auto* header = reinterpret_cast<RecordHeader*>(&ring.data[offset]);
+    header->size = static_cast<uint32_t>(needed);
+    header->level = static_cast<uint8_t>(level);
+    header->argCount = argCount;
+    header->time = logger().now();
+    header->format = format;
+    // Publishing the padding now is fine, commit() covers the record itself.
+    ring.head.store(head, std::memory_order_release);
+    ring.reservedEnd = head + needed;
+    return reinterpret_cast<std::byte*>(header + 1);
+}
+
+void commit() {
+    Ring& ring = threadRing();
+    ring.head.store(ring.reservedEnd, std::memory_order_seq_cst);
+    logger().notify();
+}
+
+void flush() {
+    logger().flush();
+}
+
+} // namespace logging
@@ -0,0 +1,177 @@
+#include "series-pyramid.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// Buckets computed per parallelFor chunk.
+constexpr size_t bucketGrain = 4096;
+
+}
+
+template<ChartValue T>
+SeriesPyramid<T>::SeriesPyramid(Dataset<T> samples, ThreadPool& pool)
+        : pool(pool), base(std::move(samples)), version(base.getVersion()) {
+    update(0);
+}
+
+template<ChartValue T>
+void SeriesPyramid<T>::append(std::span<const T> samples) {
+    if (samples.empty()) return;
+    size_t previous = size();
+    tail.insert(tail.end(), samples.begin(), samples.end());
+    version = nextDatasetVersion();
+    update(previous);
+}
+
+template<ChartValue T>
+void SeriesPyramid<T>::update(size_t fromSample) {
+    size_t count = size();
+    for (size_t level = 0;; ++level) {
+        unsigned shift = baseLevel + static_cast<unsigned>(level);
+        size_t bucketSize = size_t{1} << shift;
+        size_t buckets = (count + bucketSize - 1) / bucketSize;
+        // The top level is the first to fit one bucket.
+        if (buckets == 0 || (level > 0 && levels[level - 1].size() <= 1)) {
+            levels.resize(level);
+            return;
+        }
+        if (levels.size() <= level) {
+            levels.emplace_back();
+        }
+
+        std::vector<Bucket>& current = levels[level];
+        size_t dirty = std::min(fromSample >> shift, current.size());
+        current.resize(buckets);
+
+        if (level == 0) {
+            pool.parallelFor(buckets - dirty, bucketGrain, [&](size_t begin, size_t end) {
+                for (size_t bucket = dirty + begin; bucket < dirty + end; ++bucket) {
+                    size_t first = bucket << shift;
+                    size_t last = std::min(first + bucketSize, count);
+                    Bucket summary{first, first, at(first), at(first)};
+                    for (size_t i = first + 1; i < last; ++i) {
+                        T value = at(i);
+                        if (value < summary.minValue) {
+                            summary.minValue = value;
+                            summary.minIndex = i;
+                        }
+                        if (value > summary.maxValue) {
+                            summary.maxValue = value;
+                            summary.maxIndex = i;
+                        }
+                    }
+                    current[bucket] = summary;
+                }
+            });
+        } else {
+            const std::vector<Bucket>& finer = levels[level - 1];
+            pool.parallelFor(buckets - dirty, bucketGrain, [&](size_t begin, size_t end) {
+                for (size_t bucket = dirty + begin; bucket < dirty + end; ++bucket) {
+                    Bucket summary = finer[bucket * 2];
+                    if (bucket * 2 + 1 < finer.size()) {
+                        const Bucket& right = finer[bucket * 2 + 1];
+                        if (right.minValue < summary.minValue) {
+                            summary.minValue = right.minValue;
+                            summary.minIndex = right.minIndex;
+                        }
+                        if (right.maxValue > summary.maxValue) {
+                            summary.maxValue = right.maxValue;
+                            summary.maxIndex = right.maxIndex;
+                        }
+                    }
+                    current[bucket] = summary;
+                }
+            });
+        }
+    }
+}
+
+template<ChartValue T>
+typename SeriesPyramid<T>::Bucket SeriesPyramid<T>::extremes(size_t first, size_t last) const {
+    Bucket result{first, first, at(first), at(first)};
+    auto take = [&result](const Bucket& bucket) {
+        if (bucket.minValue < result.minValue) {
+            result.minValue = bucket.minValue;
+            result.minIndex = bucket.minIndex;
+        }
+        if (bucket.maxValue > result.maxValue) {
+            result.maxValue = bucket.maxValue;
+            result.maxIndex = bucket.maxIndex;
+        }
+    };
+
+    size_t count = size();
+    size_t i = first;
+    while (i < last) {
+        // Largest bucket starting at i that ends inside the range; the last
+        // bucket of a level may be short and ends at the end of the series.
+        size_t step = 1;
+        size_t alignment = i == 0 ? size_t{1} << 63 : size_t{1} << std::countr_zero(i);
+        for (size_t level = levels.size(); level-- > 0;) {
+            unsigned shift = baseLevel + static_cast<unsigned>(level);
+            size_t bucketSize = size_t{1} << shift;
+            if (bucketSize > alignment) continue;
+            size_t end = std::min(i + bucketSize, count);
+            if (end <= last) {
+                take(levels[level][i >> shift]);
+                step = end - i;
+                break;
+            }
+        }
+        if (step == 1) {
+            T value = at(i);
+            take(Bucket{i, i, value, value});
+        }
+        i += step;
+    }
+    return result;
+}
+
+template<ChartValue T>
+void SeriesPyramid<T>::window(size_t first, size_t last, size_t columns, std::vector<size_t>& out) const {
+    last = std::min(last, size());
+    if (first >= last) return;
+    size_t count = last - first;
+
+    if (columns == 0 || count <= columns * 4) {
+        for (size_t i = first; i < last; ++i) {
+            out.push_back(i);
+        }
+        return;
+    }
+
+    // Edges snap to the largest buckets no wider than a column, so a column
+    // covers one to three of them.
+    size_t snap = std::bit_floor(count / columns);
+    if (snap < (size_t{1} << baseLevel)) snap = 1;
+
+    out.reserve(out.size() + columns * 4);
+    size_t begin = first;
+    for (size_t column = 0; column < columns && begin < last; ++column) {
+        size_t end = last;
+        if (column + 1 < columns) {
+            end = first + (column + 1) * count / columns;
+            end = std::min(std::max(end / snap * snap, begin + 1), last);
+        }
+
+        Bucket summary = extremes(begin, end);
+        size_t picks[4] = {begin, std::min(summary.minIndex, summary.maxIndex),
+                           std::max(summary.minIndex, summary.maxIndex), end - 1};
+        for (size_t pick : picks) {
+            if (out.empty() || out.back() < pick) out.push_back(pick);
+        }
+        begin = end;
+    }
+}
+
+template<ChartValue T>
+std::pair<T, T> SeriesPyramid<T>::range(size_t first, size_t last) const {
+    Bucket summary = extremes(first, last);
+    return {summary.minValue, summary.maxValue};
+}
+
+template class SeriesPyramid<int32_t>;
+template class SeriesPyramid<int64_t>;
+template class SeriesPyramid<float>;
+template class SeriesPyramid<double>;
@@ -0,0 +1,129 @@
+#include "shm-feed.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t strideFor(uint32_t samplesPerSlot) {
+    size_t bytes = sizeof(ShmFeedSlot) + size_t{samplesPerSlot} * sizeof(double);
+    return static_cast<uint32_t>((bytes + 63) / 64 * 64);
+}
+
+}
+
+ShmFeedWriter::ShmFeedWriter(const std::string& name, uint32_t slotCount, uint32_t samplesPerSlot)
+        : name(name) {
+    slotCount = std::bit_ceil(std::max<uint32_t>(slotCount, 2));
+    samplesPerSlot = std::max<uint32_t>(samplesPerSlot, 1);
+    uint32_t stride = strideFor(samplesPerSlot);
+    size = sizeof(ShmFeedHeader) + size_t{slotCount} * stride;
+
+    fd = name.empty() ? memfd_create("gwaytool-feed", MFD_CLOEXEC)
+                      : shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create feed segment: " + std::string(strerror(errno)));
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+        close(fd);
+        throw std::runtime_error("Failed to size feed segment: " + std::string(strerror(errno)));
+    }
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map feed segment: " + std::string(strerror(errno)));
+    }
+
+    // The segment starts zeroed, so readers see no published slots until the header is complete.
+    header = static_cast<ShmFeedHeader*>(base);
+    header->slotCount = slotCount;
+    header->samplesPerSlot = samplesPerSlot;
+    header->slotStride = stride;
+    header->version = shmFeedVersion;
+    std::atomic_ref<uint32_t>(header->magic).store(shmFeedMagic, std::memory_order_release);
+}
+
+ShmFeedWriter::~ShmFeedWriter() {
+    munmap(base, size);
+    close(fd);
+    if (!name.empty()) {
+        shm_unlink(name.c_str());
+    }
+}
+
+void ShmFeedWriter::write(std::span<const double> samples) {
+    while (!samples.empty()) {
+        uint32_t count = static_cast<uint32_t>(std::min<size_t>(samples.size(), header->samplesPerSlot));
+        size_t index = next & (header->slotCount - 1);
+        auto* slot = reinterpret_cast<ShmFeedSlot*>(static_cast<std::byte*>(base) + sizeof(ShmFeedHeader) +
+                                                    index * header->slotStride);
+
+        slot->sequence.store(2 * next + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->count = count;
+        std::memcpy(reinterpret_cast<double*>(slot + 1), samples.data(), count * sizeof(double));
+        slot->sequence.store(2 * next + 2, std::memory_order_release);
+
+        next++;
+        header->published.store(next, std::memory_order_release);
+        samples = samples.subspan(count);
+    }
+}
+
+ShmFeedReader::ShmFeedReader(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open feed " + name + ": " + std::string(strerror(errno)));
+    }
+    try {
+        map(fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+ShmFeedReader::ShmFeedReader(int fd) {
+    map(fd);
+}
+
+ShmFeedReader::~ShmFeedReader() {
+    munmap(const_cast<void*>(base), size);
+}
+
+void ShmFeedReader::map(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) == -1 || static_cast<size_t>(info.st_size) < sizeof(ShmFeedHeader)) {
+        throw std::runtime_error("Feed segment is too small");
+    }
+    size = static_cast<size_t>(info.st_size);
+    base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Failed to map feed segment: " + std::string(strerror(errno)));
+    }
+
+    header = static_cast<const ShmFeedHeader*>(base);
+    uint32_t magic = std::atomic_ref<uint32_t>(const_cast<uint32_t&>(header->magic)).load(std::memory_order_acquire);
+    slotCount = header->slotCount;
+    samplesPerSlot = header->samplesPerSlot;
+    slotStride = header->slotStride;
+    bool valid = magic == shmFeedMagic && header->version == shmFeedVersion &&
+                 std::has_single_bit(slotCount) && samplesPerSlot > 0 &&
+                 slotStride >= strideFor(samplesPerSlot) &&
+                 size >= sizeof(ShmFeedHeader) + size_t{slotCount} * slotStride;
+    if (!valid) {
+        munmap(const_cast<void*>(base), size);
+        throw std::runtime_error("Not a feed segment, or an unsupported version");
+    }
+    staging.resize(samplesPerSlot);
+
+    // Start with whatever backlog the ring still holds.
+    uint64_t published = header->published.load(std::memory_order_acquire);
+    next = published > slotCount ? published - slotCount : 0;
+}
@@ -0,0 +1,94 @@
+#include "stream-series.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+template<ChartValue T>
+StreamSeries<T>::StreamSeries(size_t capacity, size_t history)
+        : mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+          ring(new T[mask + 1]),
+          history(std::max<size_t>(history, 1)),
+          windowBuffer(this->history * 2) {
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd == -1) {
+        throw std::runtime_error("Failed to create stream eventfd");
+    }
+}
+
+template<ChartValue T>
+StreamSeries<T>::~StreamSeries() {
+    close(eventFd);
+}
+
+template<ChartValue T>
+size_t StreamSeries<T>::push(std::span<const T> samples) {
+    size_t position = head.load(std::memory_order_relaxed);
+    size_t free = mask + 1 - (position - tail.load(std::memory_order_acquire));
+    size_t count = std::min(samples.size(), free);
+    if (count < samples.size()) {
+        dropped.fetch_add(samples.size() - count, std::memory_order_relaxed);
+    }
+    if (count == 0) return 0;
+
+    size_t start = position & mask;
+    size_t first = std::min(count, mask + 1 - start);
+    std::memcpy(ring.get() + start, samples.data(), first * sizeof(T));
+    std::memcpy(ring.get(), samples.data() + first, (count - first) * sizeof(T));
+    // Sequentially consistent with drain's clear and load: either the reader
+    // sees these samples or this sees the flag cleared and wakes it.
+    head.store(position + count, std::memory_order_seq_cst);
+    if (!signalled.exchange(true, std::memory_order_seq_cst)) {
+        uint64_t one = 1;
+        // Cannot block, the eventfd is non-blocking and the reader resets it.
+        [[maybe_unused]] ssize_t written = write(eventFd, &one, sizeof(one));
+    }
+    return count;
+}
+
+template<ChartValue T>
+size_t StreamSeries<T>::drain() {
+    signalled.store(false, std::memory_order_seq_cst);
+
+    size_t position = tail.load(std::memory_order_relaxed);
+    size_t count = head.load(std::memory_order_seq_cst) - position;
+    if (count == 0) return 0;
+
+    size_t start = position & mask;
+    size_t first = std::min(count, mask + 1 - start);
+    appendToWindow(ring.get() + start, first);
+    appendToWindow(ring.get(), count - first);
+    tail.store(position + count, std::memory_order_release);
+    received += count;
+    return count;
+}
+
+template<ChartValue T>
+void StreamSeries<T>::appendToWindow(const T* samples, size_t count) {
+    if (count >= history) {
+        std::copy(samples + count - history, samples + count, windowBuffer.begin());
+        windowEnd = history;
+        return;
+    }
+    if (windowEnd + count > windowBuffer.size()) {
+        size_t keep = std::min(windowEnd, history - count);
+        std::copy(windowBuffer.begin() + static_cast<std::ptrdiff_t>(windowEnd - keep),
+                  windowBuffer.begin() + static_cast<std::ptrdiff_t>(windowEnd), windowBuffer.begin());
+        windowEnd = keep;
+    }
+    std::copy(samples, samples + count, windowBuffer.begin() + static_cast<std::ptrdiff_t>(windowEnd));
+    windowEnd += count;
+}
+
+template<ChartValue T>
+std::span<const T> StreamSeries<T>::window() const {
+    size_t size = std::min(windowEnd, history);
+    return std::span<const T>(windowBuffer.data() + windowEnd - size, size);
+}
+
+template class StreamSeries<int32_t>;
+template class StreamSeries<int64_t>;
+template class StreamSeries<float>;
+template class StreamSeries<double>;
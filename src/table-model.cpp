@@ -0,0 +1,68 @@
+#include "table-model.h"
+#include <charconv>
+#include <unordered_map>
+
+namespace {
+
+struct CategoryColumn {
+    std::vector<int32_t> codes;
+    std::vector<std::string> names;
+};
+
+}
+
+TableModel::TableModel(std::vector<Row> rows) : rows(std::move(rows)) {
+}
+
+template<typename T>
+Dataset<T> TableModel::column(size_t index, size_t firstRow) const {
+    std::lock_guard<std::mutex> lock(columnsLock);
+    CachedColumn& cached = columns[{index, firstRow, std::type_index(typeid(T))}];
+    if (!cached.buffer) {
+        auto values = std::make_shared<std::vector<T>>();
+        if (firstRow < rows.size()) {
+            values->reserve(rows.size() - firstRow);
+        }
+        for (size_t row = firstRow; row < rows.size(); ++row) {
+            T value{};
+            if (index < rows[row].size()) {
+                const std::string& cell = rows[row][index];
+                std::from_chars(cell.data(), cell.data() + cell.size(), value);
+            }
+            values->push_back(value);
+        }
+        cached.buffer = std::move(values);
+        cached.version = nextDatasetVersion();
+    }
+
+    auto buffer = std::static_pointer_cast<const std::vector<T>>(cached.buffer);
+    std::span<const T> values(*buffer);
+    return Dataset<T>(std::move(buffer), values, cached.version);
+}
+
+template Dataset<int> TableModel::column<int>(size_t index, size_t firstRow) const;
+template Dataset<double> TableModel::column<double>(size_t index, size_t firstRow) const;
+
+TableModel::Categories TableModel::categories(size_t index, size_t firstRow) const {
+    std::lock_guard<std::mutex> lock(columnsLock);
+    CachedColumn& cached = columns[{index, firstRow, std::type_index(typeid(CategoryColumn))}];
+    if (!cached.buffer) {
+        auto column = std::make_shared<CategoryColumn>();
+        std::unordered_map<std::string_view, int32_t> codes;
+        for (size_t row = firstRow; row < rows.size(); ++row) {
+            std::string_view cell = index < rows[row].size() ? std::string_view(rows[row][index]) : std::string_view();
+            auto [position, added] = codes.try_emplace(cell, static_cast<int32_t>(column->names.size()));
+            if (added) {
+                column->names.emplace_back(cell);
+            }
+            column->codes.push_back(position->second);
+        }
+        cached.buffer = std::move(column);
+        cached.version = nextDatasetVersion();
+    }
+
+    auto column = std::static_pointer_cast<const CategoryColumn>(cached.buffer);
+    std::span<const int32_t> codes(column->codes);
+    std::vector<std::string> names = column->names;
+    return Categories{Dataset<int32_t>(std::move(column), codes, cached.version), std::move(names)};
+}
@@ -0,0 +1,415 @@
+#include "application.h"
+#include "utf8.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Text is measured on a scratch context that lives as long as the program.
+cairo_t* measureContext() {
+    static cairo_t* cr = [] {
+        cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+        cairo_t* context = cairo_create(surface);
+        cairo_surface_destroy(surface);
+        cairo_select_font_face(context, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size(context, TextInput::fontSize);
+        return context;
+    }();
+    return cr;
+}
+
+float advanceOf(std::string_view cluster) {
+    // Single code points are the common case and get the cheaper key.
+    static std::unordered_map<uint32_t, float> codepointCache;
+    static std::unordered_map<std::string, float> clusterCache;
+
+    uint32_t codepoint;
+    bool single = decodeUtf8(cluster, 0, codepoint) == cluster.size();
+    if (single) {
+        auto it = codepointCache.find(codepoint);
+        if (it != codepointCache.end()) return it->second;
+    } else {
+        auto it = clusterCache.find(std::string(cluster));
+        if (it != clusterCache.end()) return it->second;
+    }
+
+    std::string glyph(cluster);
+    cairo_text_extents_t extents;
+    cairo_text_extents(measureContext(), glyph.c_str(), &extents);
+    auto advance = static_cast<float>(extents.x_advance);
+    if (single) {
+        codepointCache.emplace(codepoint, advance);
+    } else {
+        clusterCache.emplace(std::move(glyph), advance);
+    }
+    return advance;
+}
+
+// Lines are cut on grapheme cluster boundaries, which also become the caret
+// stops, so editing never has to look at the bytes again.
+void wrapParagraph(const std::string& text, size_t begin, size_t end, float maxWidth, std::vector<TextLine>& out) {
+    static std::vector<uint32_t> boundaries;
+    boundaries.clear();
+    std::string_view paragraph(text.data() + begin, end - begin);
+    appendGraphemeBoundaries(paragraph, boundaries);
+
+    TextLine line;
+    line.start = begin;
+    float x = 0;
+    size_t clusterStart = begin;
+    for (uint32_t boundary : boundaries) {
+        size_t clusterEnd = begin + boundary;
+        float advance = advanceOf(paragraph.substr(clusterStart - begin, clusterEnd - clusterStart));
+        if (x + advance > maxWidth && line.stops.size() > 1) {
+            line.end = clusterStart;
+            out.push_back(std::move(line));
+            line = TextLine{};
+            line.start = clusterStart;
+            line.startsParagraph = false;
+            x = 0;
+        }
+        x += advance;
+        line.stops.push_back(static_cast<uint32_t>(clusterEnd - line.start));
+        line.xs.push_back(x);
+        clusterStart = clusterEnd;
+    }
+    line.end = end;
+    out.push_back(std::move(line));
+}
+
+} // namespace
+
+TextInput::TextInput(int x, int y, int width, int height, std::optional<std::string> filePath,
+                     PersistenceOptions persistenceOptions)
+        : x(x), y(y), width(width), height(height),
+          persistence(filePath.value_or("output.txt"), persistenceOptions) {
+    text = persistence.takeRecoveredDocument();
+    relayout(0, 0, text.size());
+    caret = anchor = text.size();
+}
+
+void TextInput::draw(cairo_t* cr) const {
+    cairo_set_source_rgb(cr, isFocused ? 0.8 : 0.9, 0.9, 0.9);
+    cairo_rectangle(cr, x, y, width, height);
+    cairo_fill(cr);
+
+    cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_rectangle(cr, x, y, width, height);
+    cairo_stroke(cr);
+
+    // Only lines inside the clip are painted, so redrawing the caret area
+    // does not cost a pass over the whole text.
+    double clipX1, clipY1, clipX2, clipY2;
+    cairo_clip_extents(cr, &clipX1, &clipY1, &clipX2, &clipY2);
+    auto firstLine = static_cast<size_t>(std::max(0.0, (clipY1 - y) / lineHeight));
+    auto lastLine = std::min(lines.size(), static_cast<size_t>(std::max(0.0, (clipY2 - y) / lineHeight + 1)));
+
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, fontSize);
+
+    size_t selStart = selectionStart(), selEnd = selectionEnd();
+    for (size_t i = firstLine; i < lastLine; ++i) {
+        const TextLine& line = lines[i];
+        if (bulkStart && line.end > *bulkStart) break; // not laid out yet
+        int lineTop = y + static_cast<int>(i) * lineHeight;
+
+        if (selStart < selEnd && selStart <= line.end && selEnd > line.start) {
+            float from = line.xs[stopIndex(line, std::max(selStart, line.start))];
+            float to = line.xs[stopIndex(line, std::min(selEnd, line.end))];
+            if (selEnd > line.end) {
+                to += 4; // the selected line break
+            }
+            cairo_set_source_rgb(cr, 0.6, 0.75, 1.0);
+            cairo_rectangle(cr, x + padding + from, lineTop + 2, to - from, lineHeight);
+            cairo_fill(cr);
+        }
+
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_move_to(cr, x + padding, lineTop + lineHeight - 5);
+        cairo_show_text(cr, text.substr(line.start, line.end - line.start).c_str());
+    }
+
+    if (isFocused) {
+        size_t caretLine = lineAt(caret);
+        double cx = x + padding + caretX(caret) + 0.5;
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_set_line_width(cr, 1.0);
+        cairo_move_to(cr, cx, y + static_cast<int>(caretLine) * lineHeight + 4);
+        cairo_line_to(cr, cx, y + static_cast<int>(caretLine + 1) * lineHeight);
+        cairo_stroke(cr);
+    }
+}
+
+void TextInput::handleKeyPress(uint32_t keysym, KeyModifiers modifiers) {
+    if (isBulkInserting()) return;
+    bool keepPreferredX = false;
+
+    switch (keysym) {
+        case XKB_KEY_Left:
+            if (hasSelection() && !modifiers.shift) {
+                moveCaret(selectionStart(), false);
+            } else {
+                moveCaret(previousStop(caret), modifiers.shift);
+            }
+            break;
+        case XKB_KEY_Right:
+            if (hasSelection() && !modifiers.shift) {
+                moveCaret(selectionEnd(), false);
+            } else {
+                moveCaret(nextStop(caret), modifiers.shift);
+            }
+            break;
+        case XKB_KEY_Up:
+        case XKB_KEY_Down: {
+            size_t current = lineAt(caret);
+            float targetX = preferredX.value_or(caretX(caret));
+            if (keysym == XKB_KEY_Up && current == 0) {
+                moveCaret(0, modifiers.shift);
+            } else if (keysym == XKB_KEY_Down && current + 1 == lines.size()) {
+                moveCaret(text.size(), modifiers.shift);
+            } else {
+                const TextLine& target = lines[keysym == XKB_KEY_Up ? current - 1 : current + 1];
+                size_t i = std::lower_bound(target.xs.begin(), target.xs.end(), targetX) - target.xs.begin();
+                if (i == target.xs.size() || (i > 0 && targetX - target.xs[i - 1] < target.xs[i] - targetX)) {
+                    i--;
+                }
+                moveCaret(target.start + target.stops[i], modifiers.shift);
+            }
+            preferredX = targetX;
+            keepPreferredX = true;
+            break;
+        }
+        case XKB_KEY_Home:
+            moveCaret(modifiers.ctrl ? 0 : lines[lineAt(caret)].start, modifiers.shift);
+            break;
+        case XKB_KEY_End:
+            moveCaret(modifiers.ctrl ? text.size() : lines[lineAt(caret)].end, modifiers.shift);
+            break;
+        case XKB_KEY_BackSpace:
+            if (hasSelection()) {
+                replaceSelection({});
+            } else if (caret > 0) {
+                size_t previous = previousStop(caret);
+                erase(previous, caret - previous);
+            }
+            break;
+        case XKB_KEY_Delete:
+            if (hasSelection()) {
+                replaceSelection({});
+            } else if (caret < text.size()) {
+                erase(caret, nextStop(caret) - caret);
+            }
+            break;
+        case XKB_KEY_Return:
+            replaceSelection("\n");
+            break;
+        default: {
+            if (modifiers.ctrl) {
+                if (keysym == XKB_KEY_a || keysym == XKB_KEY_A) {
+                    anchor = 0;
+                    caret = text.size();
+                }
+                break;
+            }
+            char buffer[8];
+            int size = xkb_keysym_to_utf8(keysym, buffer, sizeof(buffer));
+            if (size > 0) {
+                // The returned size counts the terminating null byte.
+                replaceSelection(std::string_view(buffer, std::strlen(buffer)));
+            }
+        }
+    }
+
+    if (!keepPreferredX) {
+        preferredX.reset();
+    }
+}
+
+void TextInput::handleClick(int px, int py, bool extendSelection) {
+    if (isBulkInserting()) return;
+    moveCaret(offsetAt(px, py), extendSelection);
+    preferredX.reset();
+}
+
+void TextInput::moveCaret(size_t offset, bool extendSelection) {
+    caret = std::min(offset, text.size());
+    if (!extendSelection) {
+        anchor = caret;
+    }
+}
+
+void TextInput::insert(size_t offset, std::string_view bytes) {
+    if (isBulkInserting() || offset > text.size() || bytes.empty()) return;
+    text.insert(offset, bytes);
+    persistence.record(EditOp::insert(offset, std::string(bytes)));
+    relayout(offset, 0, bytes.size());
+
+    if (caret >= offset) caret += bytes.size();
+    if (anchor >= offset) anchor += bytes.size();
+    revision++;
+}
+
+void TextInput::erase(size_t offset, size_t length) {
+    if (isBulkInserting() || offset >= text.size() || length == 0) return;
+    length = std::min(length, text.size() - offset);
+    text.erase(offset, length);
+    persistence.record(EditOp::erase(offset, length));
+    relayout(offset, length, 0);
+
+    auto shift = [offset, length](size_t position) {
+        if (position <= offset) return position;
+        return position < offset + length ? offset : position - length;
+    };
+    caret = shift(caret);
+    anchor = shift(anchor);
+    revision++;
+}
+
+void TextInput::replaceSelection(std::string_view bytes) {
+    if (hasSelection()) {
+        size_t start = selectionStart();
+        erase(start, selectionEnd() - start);
+    }
+    insert(caret, bytes);
+    anchor = caret;
+}
+
+void TextInput::beginBulkInsert() {
+    if (isBulkInserting()) return;
+    if (hasSelection()) {
+        replaceSelection({});
+    }
+    bulkStart = caret;
+    bulkTail.assign(text, caret);
+    text.resize(caret);
+}
+
+void TextInput::appendBulk(std::string_view chunk) {
+    if (isBulkInserting()) {
+        text.append(chunk);
+    }
+}
+
+void TextInput::endBulkInsert() {
+    if (!isBulkInserting()) return;
+    size_t start = *bulkStart;
+    size_t inserted = text.size() - start;
+    text += bulkTail;
+    bulkTail.clear();
+    bulkTail.shrink_to_fit();
+    bulkStart.reset();
+    if (inserted == 0) return;
+
+    persistence.record(EditOp::insert(start, text.substr(start, inserted)));
+    relayout(start, 0, inserted);
+    caret = anchor = start + inserted;
+    revision++;
+}
+
+std::string TextInput::getInputText() const {
+    std::string input;
+    input.reserve(text.size());
+    std::copy_if(text.begin(), text.end(), std::back_inserter(input), [](char c) { return c != '\n'; });
+    return input;
+}
+
+size_t TextInput::lineAt(size_t offset) const {
+    auto it = std::upper_bound(lines.begin(), lines.end(), offset,
+                               [](size_t value, const TextLine& line) { return value < line.start; });
+    return it == lines.begin() ? 0 : static_cast<size_t>(it - lines.begin()) - 1;
+}
+
+size_t TextInput::stopIndex(const TextLine& line, size_t offset) const {
+    auto relative = static_cast<uint32_t>(std::min(offset, line.end) - std::min(offset, line.start));
+    auto it = std::lower_bound(line.stops.begin(), line.stops.end(), relative);
+    return std::min(static_cast<size_t>(it - line.stops.begin()), line.stops.size() - 1);
+}
+
+float TextInput::caretX(size_t offset) const {
+    const TextLine& line = lines[lineAt(offset)];
+    return line.xs[stopIndex(line, offset)];
+}
+
+size_t TextInput::previousStop(size_t offset) const {
+    size_t index = lineAt(offset);
+    const TextLine& line = lines[index];
+    size_t stop = stopIndex(line, offset);
+    if (stop > 0) return line.start + line.stops[stop - 1];
+    if (index == 0) return 0;
+
+    const TextLine& previous = lines[index - 1];
+    if (line.startsParagraph) return previous.end;
+    return previous.start + previous.stops[previous.stops.size() - 2];
+}
+
+size_t TextInput::nextStop(size_t offset) const {
+    size_t index = lineAt(offset);
+    const TextLine& line = lines[index];
+    size_t stop = stopIndex(line, offset);
+    if (stop + 1 < line.stops.size()) return line.start + line.stops[stop + 1];
+    if (index + 1 == lines.size()) return text.size();
+
+    const TextLine& next = lines[index + 1];
+    if (next.startsParagraph) return next.start;
+    return next.start + next.stops[1];
+}
+
+size_t TextInput::offsetAt(int px, int py) const {
+    int row = (py - y) / lineHeight;
+    const TextLine& line = lines[std::clamp(row, 0, static_cast<int>(lines.size()) - 1)];
+
+    auto localX = static_cast<float>(px - x - padding);
+    size_t i = std::upper_bound(line.xs.begin(), line.xs.end(), localX) - line.xs.begin();
+    if (i == line.xs.size() || (i > 0 && localX - line.xs[i - 1] < line.xs[i] - localX)) {
+        i--;
+    }
+    return line.start + line.stops[i];
+}
+
+Rect TextInput::getCaretBounds() const {
+    size_t caretLine = lineAt(caret);
+    int cx = x + padding + static_cast<int>(caretX(caret));
+    Rect bounds{cx - 2, y + static_cast<int>(caretLine) * lineHeight, 5, lineHeight + 2};
+
+    if (hasSelection()) {
+        size_t first = lineAt(selectionStart());
+        size_t last = lineAt(selectionEnd());
+        bounds = bounds.united({x, y + static_cast<int>(first) * lineHeight,
+                                width, static_cast<int>(last - first + 1) * lineHeight + 2});
+    }
+    return bounds;
+}
+
+void TextInput::relayout(size_t offset, size_t removed, size_t inserted) {
+    // The old lines [first, last) hold the paragraphs the edit touched.
+    size_t first = lineAt(offset);
+    while (first > 0 && !lines[first].startsParagraph) {
+        first--;
+    }
+    size_t last = lineAt(offset + removed) + 1;
+    while (last < lines.size() && !lines[last].startsParagraph) {
+        last++;
+    }
+
+    size_t begin = lines[first].start;
+    size_t end = std::min(text.find('\n', offset + inserted), text.size());
+
+    std::vector<TextLine> fresh;
+    const auto maxWidth = static_cast<float>(width - 2 * padding);
+    for (size_t start = begin;;) {
+        size_t paragraphEnd = std::min(text.find('\n', start), text.size());
+        wrapParagraph(text, start, paragraphEnd, maxWidth, fresh);
+        if (paragraphEnd >= end) break;
+        start = paragraphEnd + 1;
+    }
+
+    for (size_t i = last; i < lines.size(); ++i) {
+        lines[i].start = lines[i].start + inserted - removed;
+        lines[i].end = lines[i].end + inserted - removed;
+    }
+    lines.erase(lines.begin() + static_cast<std::ptrdiff_t>(first), lines.begin() + static_cast<std::ptrdiff_t>(last));
+    lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(first),
+                 std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+
+    height = std::max(40, static_cast<int>(lines.size() * lineHeight));
+}
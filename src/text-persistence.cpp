@@ -0,0 +1,168 @@
+#include "text-persistence.h"
+#include "file-io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+TextPersistence::TextPersistence(std::string path, PersistenceOptions options)
+        : path(std::move(path)), tmpPath(this->path + ".tmp"), options(options), journal(this->path) {
+    int fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open file");
+    }
+    ::close(fd);
+
+    EditJournal::Recovered recovered = journal.recover();
+    document = recovered.document;
+    documentSequence = recovered.sequence;
+    lastSequence = recovered.sequence;
+    recoveredDocument = std::move(recovered.document);
+    if (recovered.replayedEdits > 0) {
+        // The text file may predate the crash, bring it up to date.
+        exportPending = true;
+        firstPendingAt = lastEditAt = Clock::now();
+    }
+
+    writer = std::thread(&TextPersistence::writerLoop, this);
+}
+
+TextPersistence::~TextPersistence() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    writer.join();
+}
+
+void TextPersistence::record(EditOp op) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        op.sequence = ++lastSequence;
+        pendingOps.push_back(std::move(op));
+    }
+    wakeUp.notify_one();
+}
+
+void TextPersistence::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flushRequested = true;
+    }
+    wakeUp.notify_one();
+}
+
+TextPersistence::Clock::time_point TextPersistence::exportDeadline() const {
+    return std::min(lastEditAt + options.quietPeriod, firstPendingAt + options.maxDelay);
+}
+
+void TextPersistence::writerLoop() {
+    // Signals belong to the event loop thread.
+    sigset_t signals;
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::vector<EditOp> ops;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        auto hasWork = [this] { return stopping || flushRequested || !pendingOps.empty(); };
+        if (exportPending) {
+            wakeUp.wait_until(lock, exportDeadline(), hasWork);
+        } else {
+            wakeUp.wait(lock, hasWork);
+        }
+
+        ops.swap(pendingOps);
+        bool durabilityPoint = flushRequested || stopping;
+        bool finished = stopping;
+        flushRequested = false;
+        lock.unlock();
+
+        bool sync = options.durability == Durability::EveryWrite ||
+                    (durabilityPoint && options.durability == Durability::OnFlush);
+
+        if (!ops.empty()) {
+            journal.append(ops);
+            for (const EditOp& op : ops) {
+                if (!applyEdit(document, op)) {
+                    std::cerr << "Dropping edit " << op.sequence << " outside of the document\n";
+                }
+            }
+            documentSequence = ops.back().sequence;
+
+            auto now = Clock::now();
+            if (!exportPending) {
+                firstPendingAt = now;
+                exportPending = true;
+            }
+            lastEditAt = now;
+            editsSinceExport += ops.size();
+            ops.clear();
+        }
+        if (sync) {
+            journal.sync();
+        }
+
+        if (exportPending && (durabilityPoint || editsSinceExport >= options.maxPendingEdits ||
+                              Clock::now() >= exportDeadline())) {
+            writeDocument(sync);
+            exportPending = false;
+            editsSinceExport = 0;
+        } else if (sync && unsyncedWrite) {
+            syncWritten();
+        }
+
+        // Also compact on shutdown so the next start does not replay much.
+        if (journal.getJournalBytes() > options.compactAfterBytes || (finished && !journal.isEmpty())) {
+            journal.compact(document, documentSequence);
+        }
+
+        lock.lock();
+        if (finished && pendingOps.empty()) break;
+    }
+}
+
+bool TextPersistence::writeDocument(bool sync) {
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << tmpPath << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    bool ok = writeAll(fd, document.data(), document.size());
+    if (ok && sync && ::fdatasync(fd) != 0) {
+        ok = false;
+    }
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to save " << path << ": " << std::strerror(errno) << "\n";
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    if (sync) {
+        // The rename itself is only durable once the directory is synced.
+        syncParentDirectory(path);
+    }
+    unsyncedWrite = !sync;
+    return true;
+}
+
+void TextPersistence::syncWritten() {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::close(fd);
+
+    syncParentDirectory(path);
+    unsyncedWrite = false;
+}
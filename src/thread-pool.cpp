@@ -0,0 +1,114 @@
+#include "thread-pool.h"
+#include <algorithm>
+#include <csignal>
+#include <pthread.h>
+
+ThreadPool::ThreadPool(unsigned count) {
+    if (count == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    // Signals are for the event loop's signalfd, never for the workers.
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run(size_t count, size_t grain, void (*body)(void*, size_t, size_t), void* context) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    if (count <= grain) {
+        body(context, 0, count);
+        return;
+    }
+
+    Job job;
+    job.body = body;
+    job.context = context;
+    job.count = count;
+    job.grain = grain;
+    job.chunks = (count + grain - 1) / grain;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobs.push_back(&job);
+    }
+    wake.notify_all();
+
+    runChunks(job);
+
+    // The job lives on this stack, so no worker may still be holding it.
+    std::unique_lock<std::mutex> guard(lock);
+    std::erase(jobs, &job);
+    jobDone.wait(guard, [&job] {
+        return job.finished.load(std::memory_order_acquire) == job.chunks && job.users == 0;
+    });
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::runChunks(Job& job) {
+    for (;;) {
+        size_t chunk = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job.chunks) return;
+
+        size_t begin = chunk * job.grain;
+        size_t end = std::min(begin + job.grain, job.count);
+        try {
+            job.body(job.context, begin, end);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!job.error) job.error = std::current_exception();
+        }
+
+        if (job.finished.fetch_add(1, std::memory_order_acq_rel) + 1 == job.chunks) {
+            std::lock_guard<std::mutex> guard(lock);
+            jobDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+        if (stopping) return;
+
+        Job* job = jobs.front();
+        job->users++;
+        guard.unlock();
+        runChunks(*job);
+        guard.lock();
+
+        // Every chunk is taken, so nobody needs to find the job any more.
+        if (!jobs.empty() && jobs.front() == job) {
+            jobs.pop_front();
+        }
+        job->users--;
+        if (job->users == 0) {
+            jobDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,295 @@
+#include "utf8.h"
+
+#include <algorithm>
+
+namespace {
+
+enum class Break : uint8_t {
+    Other,
+    CR,
+    LF,
+    Control,
+    Extend,
+    ZWJ,
+    RegionalIndicator,
+    Prepend,
+    SpacingMark,
+    L,
+    V,
+    T,
+    LV,
+    LVT,
+    ExtendedPictographic,
+};
+
+struct Range {
+    uint32_t first;
+    uint32_t last;
+    Break property;
+};
+
+// Grapheme_Cluster_Break and Extended_Pictographic ranges for the scripts
+// we expect to see, sorted by first and not overlapping. Code points not
+// listed are Other, which breaks on both sides.
+constexpr Range ranges[] = {
+        {0x0000, 0x0009, Break::Control}, {0x000A, 0x000A, Break::LF}, {0x000B, 0x000C, Break::Control},
+        {0x000D, 0x000D, Break::CR}, {0x000E, 0x001F, Break::Control}, {0x007F, 0x009F, Break::Control},
+        {0x00A9, 0x00A9, Break::ExtendedPictographic}, {0x00AD, 0x00AD, Break::Control},
+        {0x00AE, 0x00AE, Break::ExtendedPictographic},
+        {0x0300, 0x036F, Break::Extend}, {0x0483, 0x0489, Break::Extend}, {0x0591, 0x05BD, Break::Extend},
+        {0x05BF, 0x05BF, Break::Extend}, {0x05C1, 0x05C2, Break::Extend}, {0x05C4, 0x05C5, Break::Extend},
+        {0x05C7, 0x05C7, Break::Extend}, {0x0600, 0x0605, Break::Prepend}, {0x0610, 0x061A, Break::Extend},
+        {0x061C, 0x061C, Break::Control}, {0x064B, 0x065F, Break::Extend}, {0x0670, 0x0670, Break::Extend},
+        {0x06D6, 0x06DC, Break::Extend}, {0x06DD, 0x06DD, Break::Prepend}, {0x06DF, 0x06E4, Break::Extend},
+        {0x06E7, 0x06E8, Break::Extend}, {0x06EA, 0x06ED, Break::Extend}, {0x070F, 0x070F, Break::Prepend},
+        {0x0711, 0x0711, Break::Extend}, {0x0730, 0x074A, Break::Extend}, {0x07A6, 0x07B0, Break::Extend},
+        {0x07EB, 0x07F3, Break::Extend}, {0x0816, 0x082D, Break::Extend}, {0x0859, 0x085B, Break::Extend},
+        {0x08D3, 0x08E1, Break::Extend}, {0x08E2, 0x08E2, Break::Prepend}, {0x08E3, 0x0902, Break::Extend},
+        {0x0903, 0x0903, Break::SpacingMark}, {0x093A, 0x093A, Break::Extend},
+        {0x093B, 0x093B, Break::SpacingMark}, {0x093C, 0x093C, Break::Extend},
+        {0x093E, 0x0940, Break::SpacingMark}, {0x0941, 0x0948, Break::Extend},
+        {0x0949, 0x094C, Break::SpacingMark}, {0x094D, 0x094D, Break::Extend},
+        {0x094E, 0x094F, Break::SpacingMark}, {0x0951, 0x0957, Break::Extend}, {0x0962, 0x0963, Break::Extend},
+        {0x0981, 0x0981, Break::Extend}, {0x0982, 0x0983, Break::SpacingMark}, {0x09BC, 0x09BC, Break::Extend},
+        {0x09BE, 0x09BE, Break::Extend}, {0x09BF, 0x09C0, Break::SpacingMark}, {0x09C1, 0x09C4, Break::Extend},
+        {0x09C7, 0x09C8, Break::SpacingMark}, {0x09CB, 0x09CC, Break::SpacingMark},
+        {0x09CD, 0x09CD, Break::Extend}, {0x09D7, 0x09D7, Break::Extend}, {0x09E2, 0x09E3, Break::Extend},
+        {0x0A01, 0x0A02, Break::Extend}, {0x0A03, 0x0A03, Break::SpacingMark}, {0x0A3C, 0x0A3C, Break::Extend},
+        {0x0A3E, 0x0A40, Break::SpacingMark}, {0x0A41, 0x0A51, Break::Extend}, {0x0A70, 0x0A71, Break::Extend},
+        {0x0A75, 0x0A75, Break::Extend}, {0x0A81, 0x0A82, Break::Extend}, {0x0A83, 0x0A83, Break::SpacingMark},
+        {0x0ABC, 0x0ABC, Break::Extend}, {0x0ABE, 0x0AC0, Break::SpacingMark}, {0x0AC1, 0x0AC8, Break::Extend},
+        {0x0AC9, 0x0AC9, Break::SpacingMark}, {0x0ACB, 0x0ACC, Break::SpacingMark},
+        {0x0ACD, 0x0ACD, Break::Extend}, {0x0AE2, 0x0AE3, Break::Extend}, {0x0B01, 0x0B01, Break::Extend},
+        {0x0B02, 0x0B03, Break::SpacingMark}, {0x0B3C, 0x0B3C, Break::Extend}, {0x0B3E, 0x0B3F, Break::Extend},
+        {0x0B40, 0x0B40, Break::SpacingMark}, {0x0B41, 0x0B44, Break::Extend},
+        {0x0B47, 0x0B48, Break::SpacingMark}, {0x0B4B, 0x0B4C, Break::SpacingMark},
+        {0x0B4D, 0x0B4D, Break::Extend}, {0x0B56, 0x0B57, Break::Extend}, {0x0B62, 0x0B63, Break::Extend},
+        {0x0B82, 0x0B82, Break::Extend}, {0x0BBE, 0x0BBE, Break::Extend}, {0x0BBF, 0x0BBF, Break::SpacingMark},
+        {0x0BC0, 0x0BC0, Break::Extend}, {0x0BC1, 0x0BC2, Break::SpacingMark},
+        {0x0BC6, 0x0BC8, Break::SpacingMark}, {0x0BCA, 0x0BCC, Break::SpacingMark},
+        {0x0BCD, 0x0BCD, Break::Extend}, {0x0BD7, 0x0BD7, Break::Extend}, {0x0C00, 0x0C00, Break::Extend},
+        {0x0C01, 0x0C03, Break::SpacingMark}, {0x0C3E, 0x0C40, Break::Extend},
+        {0x0C41, 0x0C44, Break::SpacingMark}, {0x0C46, 0x0C56, Break::Extend}, {0x0C62, 0x0C63, Break::Extend},
+        {0x0C81, 0x0C81, Break::Extend}, {0x0C82, 0x0C83, Break::SpacingMark}, {0x0CBC, 0x0CBC, Break::Extend},
+        {0x0CBE, 0x0CBE, Break::SpacingMark}, {0x0CBF, 0x0CBF, Break::Extend},
+        {0x0CC0, 0x0CC1, Break::SpacingMark}, {0x0CC2, 0x0CC2, Break::Extend},
+        {0x0CC3, 0x0CC4, Break::SpacingMark}, {0x0CC6, 0x0CC6, Break::Extend},
+        {0x0CC7, 0x0CC8, Break::SpacingMark}, {0x0CCA, 0x0CCB, Break::SpacingMark},
+        {0x0CCC, 0x0CCD, Break::Extend}, {0x0CD5, 0x0CD6, Break::Extend}, {0x0CE2, 0x0CE3, Break::Extend},
+        {0x0D00, 0x0D01, Break::Extend}, {0x0D02, 0x0D03, Break::SpacingMark}, {0x0D3B, 0x0D3C, Break::Extend},
+        {0x0D3E, 0x0D3E, Break::Extend}, {0x0D3F, 0x0D40, Break::SpacingMark}, {0x0D41, 0x0D44, Break::Extend},
+        {0x0D46, 0x0D48, Break::SpacingMark}, {0x0D4A, 0x0D4C, Break::SpacingMark},
+        {0x0D4D, 0x0D4D, Break::Extend}, {0x0D57, 0x0D57, Break::Extend}, {0x0D62, 0x0D63, Break::Extend},
+        {0x0D82, 0x0D83, Break::SpacingMark}, {0x0DCA, 0x0DCA, Break::Extend}, {0x0DCF, 0x0DCF, Break::Extend},
+        {0x0DD0, 0x0DD1, Break::SpacingMark}, {0x0DD2, 0x0DD6, Break::Extend},
+        {0x0DD8, 0x0DDE, Break::SpacingMark}, {0x0DDF, 0x0DDF, Break::Extend},
+        {0x0DF2, 0x0DF3, Break::SpacingMark}, {0x0E31, 0x0E31, Break::Extend},
+        {0x0E33, 0x0E33, Break::SpacingMark}, {0x0E34, 0x0E3A, Break::Extend}, {0x0E47, 0x0E4E, Break::Extend},
+        {0x0EB1, 0x0EB1, Break::Extend}, {0x0EB3, 0x0EB3, Break::SpacingMark}, {0x0EB4, 0x0EBC, Break::Extend},
+        {0x0EC8, 0x0ECD, Break::Extend}, {0x0F18, 0x0F19, Break::Extend}, {0x0F35, 0x0F35, Break::Extend},
+        {0x0F37, 0x0F37, Break::Extend}, {0x0F39, 0x0F39, Break::Extend}, {0x0F3E, 0x0F3F, Break::SpacingMark},
+        {0x0F71, 0x0F7E, Break::Extend}, {0x0F7F, 0x0F7F, Break::SpacingMark}, {0x0F80, 0x0F84, Break::Extend},
+        {0x0F86, 0x0F87, Break::Extend}, {0x0F8D, 0x0FBC, Break::Extend}, {0x0FC6, 0x0FC6, Break::Extend},
+        {0x102D, 0x1030, Break::Extend}, {0x1031, 0x1031, Break::SpacingMark}, {0x1032, 0x1037, Break::Extend},
+        {0x1039, 0x103A, Break::Extend}, {0x103B, 0x103C, Break::SpacingMark}, {0x103D, 0x103E, Break::Extend},
+        {0x1056, 0x1057, Break::SpacingMark}, {0x1058, 0x1059, Break::Extend}, {0x105E, 0x1060, Break::Extend},
+        {0x1071, 0x1074, Break::Extend}, {0x1082, 0x1082, Break::Extend}, {0x1084, 0x1084, Break::SpacingMark},
+        {0x1085, 0x1086, Break::Extend}, {0x108D, 0x108D, Break::Extend}, {0x109D, 0x109D, Break::Extend},
+        {0x1100, 0x115F, Break::L}, {0x1160, 0x11A7, Break::V}, {0x11A8, 0x11FF, Break::T},
+        {0x135D, 0x135F, Break::Extend}, {0x1712, 0x1714, Break::Extend}, {0x1732, 0x1734, Break::Extend},
+        {0x1752, 0x1753, Break::Extend}, {0x1772, 0x1773, Break::Extend}, {0x17B4, 0x17B5, Break::Extend},
+        {0x17B6, 0x17B6, Break::SpacingMark}, {0x17B7, 0x17BD, Break::Extend},
+        {0x17BE, 0x17C5, Break::SpacingMark}, {0x17C6, 0x17C6, Break::Extend},
+        {0x17C7, 0x17C8, Break::SpacingMark}, {0x17C9, 0x17D3, Break::Extend}, {0x17DD, 0x17DD, Break::Extend},
+        {0x180B, 0x180D, Break::Extend}, {0x180E, 0x180E, Break::Control}, {0x1885, 0x1886, Break::Extend},
+        {0x18A9, 0x18A9, Break::Extend}, {0x1920, 0x1922, Break::Extend}, {0x1923, 0x1926, Break::SpacingMark},
+        {0x1927, 0x1928, Break::Extend}, {0x1929, 0x192B, Break::SpacingMark},
+        {0x1930, 0x1931, Break::SpacingMark}, {0x1932, 0x1932, Break::Extend},
+        {0x1933, 0x1938, Break::SpacingMark}, {0x1939, 0x193B, Break::Extend}, {0x1A17, 0x1A18, Break::Extend},
+        {0x1A19, 0x1A1A, Break::SpacingMark}, {0x1A1B, 0x1A1B, Break::Extend},
+        {0x1A55, 0x1A55, Break::SpacingMark}, {0x1A56, 0x1A56, Break::Extend},
+        {0x1A57, 0x1A57, Break::SpacingMark}, {0x1A58, 0x1A7F, Break::Extend}, {0x1AB0, 0x1AFF, Break::Extend},
+        {0x1B00, 0x1B03, Break::Extend}, {0x1B04, 0x1B04, Break::SpacingMark}, {0x1B34, 0x1B3A, Break::Extend},
+        {0x1B3B, 0x1B3B, Break::SpacingMark}, {0x1B3C, 0x1B3C, Break::Extend},
+        {0x1B3D, 0x1B41, Break::SpacingMark}, {0x1B42, 0x1B42, Break::Extend},
+        {0x1B43, 0x1B44, Break::SpacingMark}, {0x1B6B, 0x1B73, Break::Extend}, {0x1B80, 0x1B81, Break::Extend},
+        {0x1B82, 0x1B82, Break::SpacingMark}, {0x1BA1, 0x1BA1, Break::SpacingMark},
+        {0x1BA2, 0x1BA5, Break::Extend}, {0x1BA6, 0x1BA7, Break::SpacingMark}, {0x1BA8, 0x1BA9, Break::Extend},
+        {0x1BAA, 0x1BAA, Break::SpacingMark}, {0x1BAB, 0x1BAD, Break::Extend}, {0x1BE6, 0x1BE6, Break::Extend},
+        {0x1BE7, 0x1BE7, Break::SpacingMark}, {0x1BE8, 0x1BE9, Break::Extend},
+        {0x1BEA, 0x1BEC, Break::SpacingMark}, {0x1BED, 0x1BED, Break::Extend},
+        {0x1BEE, 0x1BEE, Break::SpacingMark}, {0x1BEF, 0x1BF1, Break::Extend},
+        {0x1BF2, 0x1BF3, Break::SpacingMark}, {0x1C24, 0x1C2B, Break::SpacingMark},
+        {0x1C2C, 0x1C33, Break::Extend}, {0x1C34, 0x1C35, Break::SpacingMark}, {0x1C36, 0x1C37, Break::Extend},
+        {0x1CD0, 0x1CD2, Break::Extend}, {0x1CD4, 0x1CE0, Break::Extend}, {0x1CE1, 0x1CE1, Break::SpacingMark},
+        {0x1CE2, 0x1CE8, Break::Extend}, {0x1CED, 0x1CED, Break::Extend}, {0x1CF4, 0x1CF4, Break::Extend},
+        {0x1CF7, 0x1CF7, Break::SpacingMark}, {0x1CF8, 0x1CF9, Break::Extend}, {0x1DC0, 0x1DFF, Break::Extend},
+        {0x200B, 0x200B, Break::Control}, {0x200C, 0x200C, Break::Extend}, {0x200D, 0x200D, Break::ZWJ},
+        {0x200E, 0x200F, Break::Control}, {0x2028, 0x202E, Break::Control},
+        {0x203C, 0x203C, Break::ExtendedPictographic}, {0x2049, 0x2049, Break::ExtendedPictographic},
+        {0x2060, 0x206F, Break::Control}, {0x20D0, 0x20F0, Break::Extend},
+        {0x2122, 0x2122, Break::ExtendedPictographic}, {0x2139, 0x2139, Break::ExtendedPictographic},
+        {0x2194, 0x2199, Break::ExtendedPictographic}, {0x21A9, 0x21AA, Break::ExtendedPictographic},
+        {0x231A, 0x231B, Break::ExtendedPictographic}, {0x2328, 0x2328, Break::ExtendedPictographic},
+        {0x2388, 0x2388, Break::ExtendedPictographic}, {0x23CF, 0x23CF, Break::ExtendedPictographic},
+        {0x23E9, 0x23F3, Break::ExtendedPictographic}, {0x23F8, 0x23FA, Break::ExtendedPictographic},
+        {0x24C2, 0x24C2, Break::ExtendedPictographic}, {0x25AA, 0x25AB, Break::ExtendedPictographic},
+        {0x25B6, 0x25B6, Break::ExtendedPictographic}, {0x25C0, 0x25C0, Break::ExtendedPictographic},
+        {0x25FB, 0x25FE, Break::ExtendedPictographic}, {0x2600, 0x27BF, Break::ExtendedPictographic},
+        {0x2934, 0x2935, Break::ExtendedPictographic}, {0x2B05, 0x2B07, Break::ExtendedPictographic},
+        {0x2B1B, 0x2B1C, Break::ExtendedPictographic}, {0x2B50, 0x2B50, Break::ExtendedPictographic},
+        {0x2B55, 0x2B55, Break::ExtendedPictographic}, {0x2CEF, 0x2CF1, Break::Extend},
+        {0x2D7F, 0x2D7F, Break::Extend}, {0x2DE0, 0x2DFF, Break::Extend}, {0x302A, 0x302F, Break::Extend},
+        {0x3030, 0x3030, Break::ExtendedPictographic}, {0x303D, 0x303D, Break::ExtendedPictographic},
+        {0x3099, 0x309A, Break::Extend}, {0x3297, 0x3297, Break::ExtendedPictographic},
+        {0x3299, 0x3299, Break::ExtendedPictographic}, {0xA66F, 0xA672, Break::Extend},
+        {0xA674, 0xA67D, Break::Extend}, {0xA69E, 0xA69F, Break::Extend}, {0xA6F0, 0xA6F1, Break::Extend},
+        {0xA802, 0xA802, Break::Extend}, {0xA806, 0xA806, Break::Extend}, {0xA80B, 0xA80B, Break::Extend},
+        {0xA823, 0xA824, Break::SpacingMark}, {0xA825, 0xA826, Break::Extend},
+        {0xA827, 0xA827, Break::SpacingMark}, {0xA880, 0xA881, Break::SpacingMark},
+        {0xA8B4, 0xA8C3, Break::SpacingMark}, {0xA8C4, 0xA8C5, Break::Extend}, {0xA8E0, 0xA8F1, Break::Extend},
+        {0xA8FF, 0xA8FF, Break::Extend}, {0xA926, 0xA92D, Break::Extend}, {0xA947, 0xA951, Break::Extend},
+        {0xA952, 0xA953, Break::SpacingMark}, {0xA960, 0xA97C, Break::L}, {0xA980, 0xA982, Break::Extend},
+        {0xA983, 0xA983, Break::SpacingMark}, {0xA9B3, 0xA9B3, Break::Extend},
+        {0xA9B4, 0xA9B5, Break::SpacingMark}, {0xA9B6, 0xA9B9, Break::Extend},
+        {0xA9BA, 0xA9BB, Break::SpacingMark}, {0xA9BC, 0xA9BD, Break::Extend},
+        {0xA9BE, 0xA9C0, Break::SpacingMark}, {0xA9E5, 0xA9E5, Break::Extend}, {0xAA29, 0xAA2E, Break::Extend},
+        {0xAA2F, 0xAA30, Break::SpacingMark}, {0xAA31, 0xAA32, Break::Extend},
+        {0xAA33, 0xAA34, Break::SpacingMark}, {0xAA35, 0xAA36, Break::Extend}, {0xAA43, 0xAA43, Break::Extend},
+        {0xAA4C, 0xAA4C, Break::Extend}, {0xAA4D, 0xAA4D, Break::SpacingMark}, {0xAA7C, 0xAA7C, Break::Extend},
+        {0xAAB0, 0xAAB0, Break::Extend}, {0xAAB2, 0xAAB4, Break::Extend}, {0xAAB7, 0xAAB8, Break::Extend},
+        {0xAABE, 0xAABF, Break::Extend}, {0xAAC1, 0xAAC1, Break::Extend}, {0xAAEB, 0xAAEB, Break::SpacingMark},
+        {0xAAEC, 0xAAED, Break::Extend}, {0xAAEE, 0xAAEF, Break::SpacingMark},
+        {0xAAF5, 0xAAF5, Break::SpacingMark}, {0xAAF6, 0xAAF6, Break::Extend},
+        {0xABE3, 0xABE4, Break::SpacingMark}, {0xABE5, 0xABE5, Break::Extend},
+        {0xABE6, 0xABE7, Break::SpacingMark}, {0xABE8, 0xABE8, Break::Extend},
+        {0xABE9, 0xABEA, Break::SpacingMark}, {0xABEC, 0xABEC, Break::SpacingMark},
+        {0xABED, 0xABED, Break::Extend}, {0xD7B0, 0xD7C6, Break::V}, {0xD7CB, 0xD7FB, Break::T},
+        {0xFB1E, 0xFB1E, Break::Extend}, {0xFE00, 0xFE0F, Break::Extend}, {0xFE20, 0xFE2F, Break::Extend},
+        {0xFEFF, 0xFEFF, Break::Control}, {0xFF9E, 0xFF9F, Break::Extend}, {0xFFF0, 0xFFFB, Break::Control},
+        {0x101FD, 0x101FD, Break::Extend}, {0x102E0, 0x102E0, Break::Extend}, {0x10376, 0x1037A, Break::Extend},
+        {0x10A01, 0x10A0F, Break::Extend}, {0x10A38, 0x10A3F, Break::Extend}, {0x11001, 0x11001, Break::Extend},
+        {0x11038, 0x11046, Break::Extend}, {0x1107F, 0x11081, Break::Extend}, {0x110B3, 0x110B6, Break::Extend},
+        {0x110B9, 0x110BA, Break::Extend}, {0x110BD, 0x110BD, Break::Prepend}, {0x110CD, 0x110CD, Break::Prepend},
+        {0x11100, 0x11102, Break::Extend}, {0x11127, 0x11134, Break::Extend}, {0x1D165, 0x1D165, Break::Extend},
+        {0x1D167, 0x1D169, Break::Extend}, {0x1D16E, 0x1D172, Break::Extend}, {0x1D17B, 0x1D182, Break::Extend},
+        {0x1D185, 0x1D18B, Break::Extend}, {0x1D1AA, 0x1D1AD, Break::Extend}, {0x1E8D0, 0x1E8D6, Break::Extend},
+        {0x1E944, 0x1E94A, Break::Extend}, {0x1F000, 0x1F0FF, Break::ExtendedPictographic},
+        {0x1F10D, 0x1F10F, Break::ExtendedPictographic}, {0x1F12F, 0x1F12F, Break::ExtendedPictographic},
+        {0x1F16C, 0x1F171, Break::ExtendedPictographic}, {0x1F17E, 0x1F17F, Break::ExtendedPictographic},
+        {0x1F18E, 0x1F18E, Break::ExtendedPictographic}, {0x1F191, 0x1F19A, Break::ExtendedPictographic},
+        {0x1F1AD, 0x1F1E5, Break::ExtendedPictographic}, {0x1F1E6, 0x1F1FF, Break::RegionalIndicator},
+        {0x1F201, 0x1F20F, Break::ExtendedPictographic}, {0x1F21A, 0x1F21A, Break::ExtendedPictographic},
+        {0x1F22F, 0x1F22F, Break::ExtendedPictographic}, {0x1F232, 0x1F23A, Break::ExtendedPictographic},
+        {0x1F23C, 0x1F23F, Break::ExtendedPictographic}, {0x1F249, 0x1F3FA, Break::ExtendedPictographic},
+        {0x1F3FB, 0x1F3FF, Break::Extend}, {0x1F400, 0x1F53D, Break::ExtendedPictographic},
+        {0x1F546, 0x1F64F, Break::ExtendedPictographic}, {0x1F680, 0x1F6FF, Break::ExtendedPictographic},
+        {0x1F774, 0x1F77F, Break::ExtendedPictographic}, {0x1F7D5, 0x1F7FF, Break::ExtendedPictographic},
+        {0x1F80C, 0x1F80F, Break::ExtendedPictographic}, {0x1F848, 0x1F84F, Break::ExtendedPictographic},
+        {0x1F85A, 0x1F85F, Break::ExtendedPictographic}, {0x1F888, 0x1F88F, Break::ExtendedPictographic},
+        {0x1F8AE, 0x1F8FF, Break::ExtendedPictographic}, {0x1F90C, 0x1F93A, Break::ExtendedPictographic},
+        {0x1F93C, 0x1F945, Break::ExtendedPictographic}, {0x1F947, 0x1FAFF, Break::ExtendedPictographic},
+        {0x1FC00, 0x1FFFD, Break::ExtendedPictographic}, {0xE0000, 0xE001F, Break::Control},
+        {0xE0020, 0xE007F, Break::Extend}, {0xE0080, 0xE00FF, Break::Control}, {0xE0100, 0xE01EF, Break::Extend},
+        {0xE01F0, 0xE0FFF, Break::Control},
+};
+
+Break propertyOf(uint32_t codepoint) {
+    if (codepoint >= 0x20 && codepoint < 0x7F) return Break::Other;
+    if (codepoint >= 0xAC00 && codepoint <= 0xD7A3) {
+        return (codepoint - 0xAC00) % 28 == 0 ? Break::LV : Break::LVT;
+    }
+    auto it = std::upper_bound(std::begin(ranges), std::end(ranges), codepoint,
+                               [](uint32_t value, const Range& range) { return value < range.first; });
+    if (it == std::begin(ranges)) return Break::Other;
+    --it;
+    return codepoint <= it->last ? it->property : Break::Other;
+}
+
+bool isControl(Break property) {
+    return property == Break::Control || property == Break::CR || property == Break::LF;
+}
+
+} // namespace
+
+size_t decodeUtf8(std::string_view text, size_t i, uint32_t& codepoint) {
+    auto byte = static_cast<unsigned char>(text[i]);
+    if (byte < 0x80) {
+        codepoint = byte;
+        return 1;
+    }
+
+    size_t length = (byte >> 5) == 0x6 ? 2 : (byte >> 4) == 0xE ? 3 : (byte >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || i + length > text.size()) {
+        codepoint = 0x80000000u | byte;
+        return 1;
+    }
+    codepoint = byte & (0xFF >> (length + 1));
+    for (size_t k = 1; k < length; ++k) {
+        auto next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xC0) != 0x80) {
+            codepoint = 0x80000000u | byte;
+            return 1;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    return length;
+}
+
+void appendGraphemeBoundaries(std::string_view text, std::vector<uint32_t>& boundaries) {
+    Break previous = Break::Control;
+    // State for GB11 (emoji ZWJ sequences) and GB12/13 (flag pairs).
+    bool pictographicRun = false;
+    bool zwjAfterPictographic = false;
+    size_t regionalIndicators = 0;
+
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codepoint;
+        size_t length = decodeUtf8(text, i, codepoint);
+        Break current = propertyOf(codepoint);
+
+        bool breakHere;
+        if (i == 0) {
+            breakHere = false;
+        } else if (previous == Break::CR && current == Break::LF) {
+            breakHere = false;
+        } else if (isControl(previous) || isControl(current)) {
+            breakHere = true;
+        } else if (previous == Break::L &&
+                   (current == Break::L || current == Break::V || current == Break::LV || current == Break::LVT)) {
+            breakHere = false;
+        } else if ((previous == Break::LV || previous == Break::V) && (current == Break::V || current == Break::T)) {
+            breakHere = false;
+        } else if ((previous == Break::LVT || previous == Break::T) && current == Break::T) {
+            breakHere = false;
+        } else if (current == Break::Extend || current == Break::ZWJ || current == Break::SpacingMark ||
+                   previous == Break::Prepend) {
+            breakHere = false;
+        } else if (previous == Break::ZWJ && current == Break::ExtendedPictographic && zwjAfterPictographic) {
+            breakHere = false;
+        } else if (previous == Break::RegionalIndicator && current == Break::RegionalIndicator) {
+            breakHere = regionalIndicators % 2 == 0;
+        } else {
+            breakHere = true;
+        }
+
+        if (breakHere) {
+            boundaries.push_back(static_cast<uint32_t>(i));
+        }
+
+        zwjAfterPictographic = current == Break::ZWJ && pictographicRun;
+        if (current == Break::ExtendedPictographic) {
+            pictographicRun = true;
+        } else if (current != Break::Extend) {
+            pictographicRun = false;
+        }
+        regionalIndicators = current == Break::RegionalIndicator ? regionalIndicators + 1 : 0;
+
+        previous = current;
+        i += length;
+    }
+
+    if (!text.empty()) {
+        boundaries.push_back(static_cast<uint32_t>(text.size()));
+    }
+}
@@ -0,0 +1,103 @@
+#include "widget-pool.h"
+
+void WidgetPool::reserve(size_t count) {
+    bounds.reserve(count);
+    flags.reserve(count);
+    labels.reserve(count);
+    callbacks.reserve(count);
+    slotOf.reserve(count);
+    slots.reserve(count);
+}
+
+WidgetHandle WidgetPool::add(const Rect& rect, std::string_view label, Callback onClick, uint8_t widgetFlags) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+
+    slots[slot].index = static_cast<uint32_t>(bounds.size());
+    bounds.push_back(rect);
+    flags.push_back(widgetFlags);
+    labels.push_back(storeLabel(label));
+    callbacks.push_back(std::move(onClick));
+    slotOf.push_back(slot);
+    return {slot, slots[slot].generation};
+}
+
+void WidgetPool::remove(WidgetHandle handle) {
+    if (!isValid(handle)) return;
+    uint32_t index = slots[handle.slot].index;
+    uint32_t last = static_cast<uint32_t>(bounds.size()) - 1;
+    deadLabelBytes += labels[index].length;
+
+    if (index != last) {
+        bounds[index] = bounds[last];
+        flags[index] = flags[last];
+        labels[index] = labels[last];
+        callbacks[index] = std::move(callbacks[last]);
+        slotOf[index] = slotOf[last];
+        slots[slotOf[index]].index = index;
+    }
+    bounds.pop_back();
+    flags.pop_back();
+    labels.pop_back();
+    callbacks.pop_back();
+    slotOf.pop_back();
+
+    slots[handle.slot].generation++;
+    freeSlots.push_back(handle.slot);
+
+    if (deadLabelBytes > 4096 && deadLabelBytes > labelArena.size() / 2) {
+        compactLabels();
+    }
+}
+
+bool WidgetPool::isValid(WidgetHandle handle) const {
+    return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation &&
+           slots[handle.slot].index < slotOf.size() && slotOf[slots[handle.slot].index] == handle.slot;
+}
+
+std::string_view WidgetPool::labelAt(size_t index) const {
+    return std::string_view(labelArena).substr(labels[index].offset, labels[index].length);
+}
+
+void WidgetPool::setFlag(WidgetHandle handle, uint8_t flag, bool on) {
+    uint8_t& widgetFlags = flags[indexOf(handle)];
+    widgetFlags = on ? widgetFlags | flag : widgetFlags & ~flag;
+}
+
+void WidgetPool::invoke(WidgetHandle handle) {
+    if (!isValid(handle)) return;
+    size_t index = indexOf(handle);
+    if ((flags[index] & WidgetEnabled) && callbacks[index]) {
+        // The callback may add or remove widgets, which moves the arrays,
+        // so it runs from a local and goes back only if its widget survived.
+        Callback onClick = std::move(callbacks[index]);
+        onClick();
+        if (isValid(handle)) {
+            callbacks[indexOf(handle)] = std::move(onClick);
+        }
+    }
+}
+
+LabelRun WidgetPool::storeLabel(std::string_view label) {
+    LabelRun run{static_cast<uint32_t>(labelArena.size()), static_cast<uint32_t>(label.size())};
+    labelArena.append(label);
+    return run;
+}
+
+void WidgetPool::compactLabels() {
+    std::string compacted;
+    compacted.reserve(labelArena.size() - deadLabelBytes);
+    for (LabelRun& run : labels) {
+        auto offset = static_cast<uint32_t>(compacted.size());
+        compacted.append(labelArena, run.offset, run.length);
+        run.offset = offset;
+    }
+    labelArena = std::move(compacted);
+    deadLabelBytes = 0;
+}